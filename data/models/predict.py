@@ -43,24 +43,9 @@ class MalwarePredictor:
         """Process a sample through the pipeline"""
         input_path = Path(input_path)
         
-        # Check if it's already an ASM file
-        if input_path.suffix == '.asm':
-            asm_file = input_path
-        elif input_path.suffix in ['.exe', '.dll']:
-            # Need to disassemble first
-            print(f"[*] Disassembling {input_path.name}...")
-            asm_file = input_path.with_suffix('.asm')
-            
-            result = subprocess.run(
-                ['./disassemble_clean.sh', str(input_path), str(asm_file)],
-                capture_output=True,
-                text=True
-            )
-            
-            if result.returncode != 0:
-                print(f"[✗] Disassembly failed")
-                return None
-        else:
+        # meef_parser reads .asm listings and disassembles .exe/.dll
+        # files itself, so either kind is passed to it as it is
+        if input_path.suffix not in ['.asm', '.exe', '.dll']:
             print(f"[✗] Unsupported file type: {input_path.suffix}")
             return None
         
@@ -70,7 +55,7 @@ class MalwarePredictor:
         ir_file.parent.mkdir(parents=True, exist_ok=True)
         
         result = subprocess.run(
-            ['./src/cd_frontend/meef_parser', str(asm_file), str(ir_file)],
+            ['./src/cd_frontend/meef_parser', str(input_path), str(ir_file)],
             capture_output=True,
             text=True
         )
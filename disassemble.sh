@@ -1,13 +1,13 @@
 #!/bin/bash
-# Clean disassembly helper for MEEF
-# Produces parser-friendly output
+# Disassembly helper for MEEF
+# meef_parser reads objdump's listing as is, addresses included
 
 print_usage() {
     echo "Usage:"
     echo "  Single file:  ./disassemble_clean.sh <file.exe> [output.asm]"
     echo "  Batch folder: ./disassemble_clean.sh <folder_path>"
     echo ""
-    echo "This version cleans objdump output to be parser-friendly"
+    echo "Writes the raw \`objdump -d -M intel\` listing, which meef_parser reads directly"
 }
 
 if [ $# -eq 0 ]; then
@@ -22,20 +22,6 @@ if ! command -v objdump &> /dev/null; then
     exit 1
 fi
 
-clean_disassembly() {
-    local RAW_FILE="$1"
-    local CLEAN_FILE="$2"
-    
-    # Extract just the instruction mnemonics and operands
-    # Remove addresses, hex bytes, section headers, etc.
-    grep -E "^\s+[0-9a-f]+:" "$RAW_FILE" | \
-        sed -E 's/^\s+[0-9a-f]+:\s+[0-9a-f ]+\s+//' | \
-        sed -E 's/\s+#.*//' | \
-        sed -E 's/\s+$//' | \
-        tr '[:lower:]' '[:upper:]' | \
-        grep -v "^$" > "$CLEAN_FILE"
-}
-
 disassemble_file() {
     local INPUT="$1"
     local OUTPUT="$2"
@@ -53,29 +39,23 @@ disassemble_file() {
     
     echo "[*] Disassembling: $(basename "$INPUT")"
     
-    # Create temporary raw disassembly
-    local TEMP_RAW="${OUTPUT}.tmp"
-    
-    # Disassemble with Intel syntax
-    objdump -d -M intel "$INPUT" > "$TEMP_RAW" 2>/dev/null
+    # Disassemble with Intel syntax; the parser strips addresses and
+    # encoding bytes itself, so there is no cleaning pass
+    objdump -d -M intel "$INPUT" > "$OUTPUT" 2>/dev/null
     
     if [ $? -ne 0 ]; then
         echo "[✗] objdump failed"
-        rm -f "$TEMP_RAW"
+        rm -f "$OUTPUT"
         return 1
     fi
     
-    # Clean the output
-    clean_disassembly "$TEMP_RAW" "$OUTPUT"
-    rm -f "$TEMP_RAW"
-    
     # Verify output
     if [ ! -f "$OUTPUT" ] || [ ! -s "$OUTPUT" ]; then
-        echo "[✗] Cleaning produced empty output"
+        echo "[✗] objdump produced empty output"
         return 1
     fi
     
-    LINES=$(wc -l < "$OUTPUT" 2>/dev/null)
+    LINES=$(grep -c $'^ *[0-9a-f]*:\t' "$OUTPUT" 2>/dev/null)
     SIZE=$(stat -c%s "$OUTPUT" 2>/dev/null || stat -f%z "$OUTPUT" 2>/dev/null)
     
     if [ "$SIZE" -gt 100 ]; then
@@ -102,7 +82,7 @@ OUTPUT_PATH="$2"
 # Check if input is a directory
 if [ -d "$INPUT_PATH" ]; then
     echo "╔══════════════════════════════════════════════════════════╗"
-    echo "║           Batch Clean Disassembly Mode                  ║"
+    echo "║              Batch Disassembly Mode                      ║"
     echo "╚══════════════════════════════════════════════════════════╝"
     echo ""
     echo "[*] Scanning folder: $INPUT_PATH"
@@ -146,7 +126,7 @@ if [ -d "$INPUT_PATH" ]; then
 elif [ -f "$INPUT_PATH" ]; then
     # Single file mode
     echo "╔══════════════════════════════════════════════════════════╗"
-    echo "║          Clean Single File Disassembly                   ║"
+    echo "║               Single File Disassembly                    ║"
     echo "╚══════════════════════════════════════════════════════════╝"
     echo ""
     
@@ -10,9 +10,10 @@ import subprocess
 import json
 import hashlib
 import csv
+import tempfile
 from pathlib import Path
 from datetime import datetime
-from typing import List, Dict, Optional
+from typing import List, Dict, Optional, Iterator, Tuple
 
 class Colors:
     HEADER = '\033[95m'
@@ -138,6 +139,41 @@ class MEEFOrchestrator:
             print(f"{Colors.RED}✗ Error running parser: {e}{Colors.RESET}")
             return False
     
+    def run_parser_batch(self, samples: List[Path]) -> Iterator[Tuple[Path, Optional[Path], Optional[str]]]:
+        """Run the MEEF parser once over all samples, yielding (sample, ir_path, error) per file"""
+        Path(self.output_dir).mkdir(parents=True, exist_ok=True)
+        by_path = {str(sample): sample for sample in samples}
+        
+        with tempfile.NamedTemporaryFile('w', suffix='.lst', delete=False) as list_file:
+            list_file.write("\n".join(str(sample) for sample in samples) + "\n")
+            list_path = list_file.name
+        
+        try:
+            cmd = [self.parser_path, "--batch", list_path, "--out-dir", self.output_dir]
+            pending = dict(by_path)
+            failed = 0
+            with subprocess.Popen(cmd, stdout=subprocess.PIPE, text=True) as proc:
+                # One tab-separated status line per input, then "DONE"
+                for line in proc.stdout:
+                    fields = line.rstrip("\n").split("\t")
+                    if fields[0] == "OK" and len(fields) >= 3:
+                        pending.pop(fields[1], None)
+                        yield by_path.get(fields[1], Path(fields[1])), Path(fields[2]), None
+                    elif fields[0] == "FAIL" and len(fields) >= 3:
+                        pending.pop(fields[1], None)
+                        failed += 1
+                        yield by_path.get(fields[1], Path(fields[1])), None, fields[2]
+                returncode = proc.wait()
+            
+            # The parser exits 1 when any sample failed; anything else means
+            # it died part way, leaving some samples unreported
+            if returncode != (1 if failed else 0):
+                print(f"{Colors.RED}✗ Parser exited with status {returncode}{Colors.RESET}")
+            for sample in pending.values():
+                yield sample, None, f"no result from parser (exit status {returncode})"
+        finally:
+            os.unlink(list_path)
+    
     def update_catalog(self, sample_path: Path, ir_path: Path, label: str = "unknown") -> None:
         """Update catalog.csv with sample metadata"""
         sha256 = self.calculate_sha256(str(sample_path))
@@ -216,25 +252,29 @@ class MEEFOrchestrator:
         
         print(f"\n{Colors.BOLD}Processing {total} sample(s)...{Colors.RESET}\n")
         
-        for idx, sample in enumerate(samples, 1):
+        # A single sample keeps the parser's full interactive report
+        if total == 1:
+            sample = samples[0]
+            output_path = Path(self.output_dir) / f"{sample.stem}_ir.json"
+            results = [(sample, output_path if self.run_parser(sample, output_path) else None, None)]
+        else:
+            # Many samples share one parser process (batch mode)
+            results = self.run_parser_batch(samples)
+        
+        for idx, (sample, output_path, error) in enumerate(results, 1):
             print(f"{Colors.CYAN}{'='*70}{Colors.RESET}")
-            print(f"{Colors.BOLD}[{idx}/{total}] Processing: {sample.name}{Colors.RESET}")
+            print(f"{Colors.BOLD}[{idx}/{total}] Processed: {sample.name}{Colors.RESET}")
             print(f"{Colors.CYAN}{'='*70}{Colors.RESET}\n")
             
-            # Generate output filename
-            output_filename = f"{sample.stem}_ir.json"
-            output_path = Path(self.output_dir) / output_filename
-            
-            # Run parser
-            success = self.run_parser(sample, output_path)
-            
-            if success:
+            if output_path is not None:
                 successful += 1
                 # Update catalog
-                print(f"\n{Colors.BLUE}Updating catalog...{Colors.RESET}")
+                print(f"{Colors.BLUE}Updating catalog...{Colors.RESET}")
                 self.update_catalog(sample, output_path)
             else:
                 failed += 1
+                if error:
+                    print(f"{Colors.RED}✗ Parser failed: {error}{Colors.RESET}")
             
             print()
         
@@ -0,0 +1,141 @@
+#include "api_cache.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define SHARD_BITS 6
+#define NUM_SHARDS (1u << SHARD_BITS)
+#define INITIAL_SHARD_CAP 64
+
+typedef struct {
+    const char *name;   // NULL for an empty slot
+    uint32_t len;
+    uint32_t hash;
+    uint32_t value;
+} CacheEntry;
+
+// Open-addressing table kept at load <= 1/2. Shards are aligned apart so
+// readers of neighbouring shards do not bounce one cache line.
+typedef struct {
+    _Alignas(64) pthread_rwlock_t lock;
+    CacheEntry *slots;
+    size_t cap;
+    size_t len;
+    Arena names;
+} CacheShard;
+
+struct ApiCache {
+    CacheShard shards[NUM_SHARDS];
+    atomic_size_t hits;
+    atomic_size_t misses;
+};
+
+ApiCache *api_cache_new(void) {
+    ApiCache *cache = aligned_alloc(64, sizeof(ApiCache));
+    memset(cache, 0, sizeof(*cache));
+    for (size_t s = 0; s < NUM_SHARDS; s++) {
+        CacheShard *shard = &cache->shards[s];
+        pthread_rwlock_init(&shard->lock, NULL);
+        shard->cap = INITIAL_SHARD_CAP;
+        shard->slots = calloc(shard->cap, sizeof(CacheEntry));
+        arena_init(&shard->names);
+    }
+    atomic_init(&cache->hits, 0);
+    atomic_init(&cache->misses, 0);
+    return cache;
+}
+
+void api_cache_free(ApiCache *cache) {
+    if (!cache) {
+        return;
+    }
+    for (size_t s = 0; s < NUM_SHARDS; s++) {
+        CacheShard *shard = &cache->shards[s];
+        pthread_rwlock_destroy(&shard->lock);
+        free(shard->slots);
+        arena_free(&shard->names);
+    }
+    free(cache);
+}
+
+// The shard takes the top bits of the hash and the slot the low ones
+static CacheShard *shard_of(ApiCache *cache, uint32_t hash) {
+    return &cache->shards[hash >> (32 - SHARD_BITS)];
+}
+
+static CacheEntry *probe(const CacheShard *shard, const char *name, size_t len, uint32_t hash) {
+    size_t mask = shard->cap - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        CacheEntry *e = &shard->slots[i];
+        if (!e->name || (e->hash == hash && e->len == len && memcmp(e->name, name, len) == 0)) {
+            return e;
+        }
+    }
+}
+
+int api_cache_find(ApiCache *cache, const char *name, size_t len, uint32_t hash,
+                   uint32_t *value) {
+    CacheShard *shard = shard_of(cache, hash);
+    pthread_rwlock_rdlock(&shard->lock);
+    const CacheEntry *e = probe(shard, name, len, hash);
+    int found = e->name != NULL;
+    if (found) {
+        *value = e->value;
+    }
+    pthread_rwlock_unlock(&shard->lock);
+    return found;
+}
+
+void api_cache_insert(ApiCache *cache, const char *name, size_t len, uint32_t hash,
+                      uint32_t value) {
+    CacheShard *shard = shard_of(cache, hash);
+    pthread_rwlock_wrlock(&shard->lock);
+
+    // Another worker may have added the name since the caller missed it
+    CacheEntry *e = probe(shard, name, len, hash);
+    if (e->name) {
+        pthread_rwlock_unlock(&shard->lock);
+        return;
+    }
+
+    if (2 * (shard->len + 1) > shard->cap) {
+        CacheEntry *old = shard->slots;
+        size_t old_cap = shard->cap;
+        shard->cap *= 2;
+        shard->slots = calloc(shard->cap, sizeof(CacheEntry));
+        for (size_t i = 0; i < old_cap; i++) {
+            if (old[i].name) {
+                *probe(shard, old[i].name, old[i].len, old[i].hash) = old[i];
+            }
+        }
+        free(old);
+        e = probe(shard, name, len, hash);
+    }
+
+    e->name = arena_strndup(&shard->names, name, len);
+    e->len = (uint32_t)len;
+    e->hash = hash;
+    e->value = value;
+    shard->len++;
+    pthread_rwlock_unlock(&shard->lock);
+}
+
+void api_cache_record(ApiCache *cache, size_t hits, size_t misses) {
+    atomic_fetch_add_explicit(&cache->hits, hits, memory_order_relaxed);
+    atomic_fetch_add_explicit(&cache->misses, misses, memory_order_relaxed);
+}
+
+void api_cache_stats(ApiCache *cache, size_t *hits, size_t *misses, size_t *names) {
+    *hits = atomic_load(&cache->hits);
+    *misses = atomic_load(&cache->misses);
+    *names = 0;
+    for (size_t s = 0; s < NUM_SHARDS; s++) {
+        CacheShard *shard = &cache->shards[s];
+        pthread_rwlock_rdlock(&shard->lock);
+        *names += shard->len;
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
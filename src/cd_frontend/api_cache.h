@@ -0,0 +1,29 @@
+#ifndef API_CACHE_H
+#define API_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Process-wide map from an API name to a 32-bit value (what
+// semantic_analyze made of it), shared by the batch workers. The table
+// is split into shards by hash, each under its own read-write lock, so
+// once the common names are in, lookups only ever take read locks and
+// rarely the same one.
+typedef struct ApiCache ApiCache;
+
+ApiCache *api_cache_new(void);
+void api_cache_free(ApiCache *cache);
+
+// hash is the name's FNV-1a hash, as cached in its Symbol. find returns
+// 1 and sets *value if the name is present; insert keeps the first value
+// stored for a name.
+int api_cache_find(ApiCache *cache, const char *name, size_t len, uint32_t hash,
+                   uint32_t *value);
+void api_cache_insert(ApiCache *cache, const char *name, size_t len, uint32_t hash,
+                      uint32_t value);
+
+// Hit counts are kept by the callers and added in once per sample
+void api_cache_record(ApiCache *cache, size_t hits, size_t misses);
+void api_cache_stats(ApiCache *cache, size_t *hits, size_t *misses, size_t *names);
+
+#endif // API_CACHE_H
@@ -0,0 +1,76 @@
+#include "api_matcher.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+void api_matcher_build(ApiMatcher *m, const ApiPattern *patterns, size_t n) {
+    memset(m->byte_class, 0, sizeof(m->byte_class));
+    m->classes = 1;
+    size_t max_states = 1;
+    for (size_t i = 0; i < n; i++) {
+        for (const unsigned char *p = (const unsigned char *)patterns[i].text; *p; p++) {
+            int c = tolower(*p);
+            if (m->byte_class[c] == 0) {
+                m->byte_class[c] = (uint8_t)m->classes++;
+            }
+            max_states++;
+        }
+    }
+    for (int c = 0; c < 256; c++) {
+        m->byte_class[c] = m->byte_class[tolower(c)];
+    }
+
+    // Trie of the folded patterns; 0 marks a missing edge, since no edge
+    // leads back to the root
+    size_t k = m->classes;
+    m->next = calloc(max_states * k, sizeof(uint32_t));
+    m->out = calloc(max_states, sizeof(uint32_t));
+    m->states = 1;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t state = 0;
+        for (const unsigned char *p = (const unsigned char *)patterns[i].text; *p; p++) {
+            uint32_t *edge = &m->next[state * k + m->byte_class[*p]];
+            if (*edge == 0) {
+                *edge = (uint32_t)m->states++;
+            }
+            state = *edge;
+        }
+        m->out[state] |= patterns[i].mask;
+    }
+
+    // Breadth-first, so a state's failure target is complete before the
+    // state itself: inherit its output, and take its edge wherever the
+    // trie has none
+    uint32_t *fail = calloc(m->states, sizeof(uint32_t));
+    uint32_t *queue = malloc(m->states * sizeof(uint32_t));
+    size_t head = 0, tail = 0;
+    for (size_t c = 0; c < k; c++) {
+        if (m->next[c] != 0) {
+            queue[tail++] = m->next[c];
+        }
+    }
+    while (head < tail) {
+        uint32_t state = queue[head++];
+        m->out[state] |= m->out[fail[state]];
+        for (size_t c = 0; c < k; c++) {
+            uint32_t *edge = &m->next[state * k + c];
+            uint32_t fallback = m->next[fail[state] * k + c];
+            if (*edge == 0) {
+                *edge = fallback;
+            } else {
+                fail[*edge] = fallback;
+                queue[tail++] = *edge;
+            }
+        }
+    }
+    free(fail);
+    free(queue);
+}
+
+void api_matcher_free(ApiMatcher *m) {
+    free(m->next);
+    free(m->out);
+    m->next = NULL;
+    m->out = NULL;
+    m->states = 0;
+}
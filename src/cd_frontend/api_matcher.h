@@ -0,0 +1,38 @@
+#ifndef API_MATCHER_H
+#define API_MATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A substring to look for in API names, and the bits it contributes
+typedef struct {
+    const char *text;
+    uint32_t mask;
+} ApiPattern;
+
+// Case-folded Aho-Corasick automaton over a set of patterns. Bytes no
+// pattern uses share one class, so a state's row holds one entry per
+// distinct pattern byte plus one.
+typedef struct {
+    uint8_t byte_class[256];
+    size_t classes;
+    size_t states;
+    uint32_t *next;     // states * classes entries, failures folded in
+    uint32_t *out;      // Per state: OR of the masks of the patterns ending there
+} ApiMatcher;
+
+void api_matcher_build(ApiMatcher *m, const ApiPattern *patterns, size_t n);
+void api_matcher_free(ApiMatcher *m);
+
+// OR of the masks of every pattern occurring in name, ignoring case,
+// found in one pass over name
+static inline uint32_t api_matcher_scan(const ApiMatcher *m, const char *name) {
+    uint32_t state = 0, mask = 0;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        state = m->next[state * m->classes + m->byte_class[*p]];
+        mask |= m->out[state];
+    }
+    return mask;
+}
+
+#endif // API_MATCHER_H
@@ -0,0 +1,67 @@
+#include "arena.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_BLOCK_SIZE (64u << 10)
+#define ARENA_ALIGN 16
+
+struct ArenaBlock {
+    ArenaBlock *next;
+};
+
+// Header size rounded up so the first allocation is aligned
+#define BLOCK_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+void arena_init(Arena *arena) {
+    arena->head = NULL;
+    arena->cur = NULL;
+    arena->end = NULL;
+}
+
+// Carve size bytes aligned to align (a power of two) from the current
+// block, starting a new block when it does not fit
+static void *bump(Arena *arena, size_t size, size_t align) {
+    uintptr_t cur = ((uintptr_t)arena->cur + align - 1) & ~(uintptr_t)(align - 1);
+
+    if (!arena->head || cur + size > (uintptr_t)arena->end) {
+        // Oversized requests get a block of their own
+        size_t block_size = size > ARENA_BLOCK_SIZE - BLOCK_HEADER
+                                ? size + BLOCK_HEADER : ARENA_BLOCK_SIZE;
+        ArenaBlock *block = malloc(block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->next = arena->head;
+        arena->head = block;
+        arena->end = (char *)block + block_size;
+        cur = (uintptr_t)block + BLOCK_HEADER;
+    }
+
+    arena->cur = (char *)(cur + size);
+    return (void *)cur;
+}
+
+void *arena_alloc(Arena *arena, size_t size) {
+    return bump(arena, size, ARENA_ALIGN);
+}
+
+// Strings need no alignment, so they pack back to back
+char *arena_strndup(Arena *arena, const char *s, size_t len) {
+    char *copy = bump(arena, len + 1, 1);
+    if (copy) {
+        memcpy(copy, s, len);
+        copy[len] = '\0';
+    }
+    return copy;
+}
+
+void arena_free(Arena *arena) {
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena_init(arena);
+}
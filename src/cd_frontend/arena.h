@@ -0,0 +1,21 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Bump allocator: allocations are carved out of large blocks and are
+// only ever released all at once by arena_free
+typedef struct {
+    ArenaBlock *head;   // Current block; older blocks are chained behind it
+    char *cur;
+    char *end;
+} Arena;
+
+void arena_init(Arena *arena);
+void *arena_alloc(Arena *arena, size_t size);
+char *arena_strndup(Arena *arena, const char *s, size_t len);
+void arena_free(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,439 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "frontend.h"
+
+// Growable list of input paths
+typedef struct {
+    char **paths;
+    size_t len;
+    size_t cap;
+} PathList;
+
+static void list_add(PathList *list, const char *path) {
+    if (list->len >= list->cap) {
+        list->cap = list->cap ? list->cap * 2 : 64;
+        list->paths = realloc(list->paths, list->cap * sizeof(char *));
+    }
+    list->paths[list->len++] = strdup(path);
+}
+
+static void list_free(PathList *list) {
+    for (size_t i = 0; i < list->len; i++) {
+        free(list->paths[i]);
+    }
+    free(list->paths);
+}
+
+static int has_asm_extension(const char *name) {
+    const char *dot = strrchr(name, '.');
+    return dot && strcmp(dot, ".asm") == 0;
+}
+
+// Collect every .asm file below dir (same selection as meef.py find_samples)
+static void collect_dir(PathList *list, const char *dir) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        perror(dir);
+        return;
+    }
+
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+            continue;
+        }
+
+        size_t n = strlen(dir) + strlen(ent->d_name) + 2;
+        char *path = malloc(n);
+        snprintf(path, n, "%s/%s", dir, ent->d_name);
+
+        struct stat st;
+        if (stat(path, &st) == 0) {
+            if (S_ISDIR(st.st_mode)) {
+                collect_dir(list, path);
+            } else if (S_ISREG(st.st_mode) && has_asm_extension(ent->d_name)) {
+                list_add(list, path);
+            }
+        }
+        free(path);
+    }
+    closedir(d);
+}
+
+// One input path per line; blank lines and '#' comments are skipped
+static int collect_list_file(PathList *list, const char *file) {
+    FILE *f = fopen(file, "r");
+    if (!f) {
+        perror(file);
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    while (getline(&line, &line_cap, f) != -1) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        list_add(list, line);
+    }
+    free(line);
+    fclose(f);
+    return 0;
+}
+
+// <out_dir>/<input stem>_ir.json, matching the orchestrator's naming,
+// or <out_dir>/<input stem>_<copy>_ir.json for a copy > 0
+static char *output_path_for(const char *out_dir, const char *infile, unsigned copy) {
+    const char *base = strrchr(infile, '/');
+    base = base ? base + 1 : infile;
+
+    const char *dot = strrchr(base, '.');
+    size_t stem_len = dot && dot != base ? (size_t)(dot - base) : strlen(base);
+
+    char suffix[16] = "";
+    if (copy > 0) {
+        snprintf(suffix, sizeof(suffix), "_%u", copy);
+    }
+
+    size_t n = strlen(out_dir) + stem_len + strlen(suffix) + sizeof("/_ir.json");
+    char *out = malloc(n);
+    snprintf(out, n, "%s/%.*s%s_ir.json", out_dir, (int)stem_len, base, suffix);
+    return out;
+}
+
+// An output path and the input in the list it was made for
+typedef struct {
+    char *path;
+    size_t input;
+} OutputName;
+
+// By path, then by position in the list
+static int compare_outputs(const void *a, const void *b) {
+    const OutputName *x = a;
+    const OutputName *y = b;
+    int c = strcmp(x->path, y->path);
+    if (c != 0) {
+        return c;
+    }
+    return (x->input > y->input) - (x->input < y->input);
+}
+
+static int output_taken(const OutputName *sorted, size_t len, const char *path) {
+    size_t lo = 0, hi = len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int c = strcmp(sorted[mid].path, path);
+        if (c == 0) {
+            return 1;
+        }
+        if (c < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return 0;
+}
+
+// Give every input its own output file. Inputs with the same stem
+// (a/x.asm and b/x.asm, or x.asm and x.exe) would otherwise be written
+// to one file by two workers at once. The first in list order keeps
+// <stem>_ir.json and the others get the first free <stem>_2_ir.json,
+// <stem>_3_ir.json, ... with a warning on stderr.
+static char **output_paths_for(const PathList *list, const char *out_dir) {
+    OutputName *names = malloc((list->len ? list->len : 1) * sizeof(OutputName));
+    for (size_t i = 0; i < list->len; i++) {
+        names[i].path = output_path_for(out_dir, list->paths[i], 0);
+        names[i].input = i;
+    }
+    qsort(names, list->len, sizeof(OutputName), compare_outputs);
+
+    char **paths = malloc((list->len ? list->len : 1) * sizeof(char *));
+    size_t first = 0;       // Start of the run of equal paths
+    unsigned copy = 1;
+    for (size_t i = 0; i < list->len; i++) {
+        if (i == 0 || strcmp(names[i].path, names[first].path) != 0) {
+            first = i;
+            copy = 1;
+            paths[names[i].input] = strdup(names[i].path);
+            continue;
+        }
+
+        char *path = NULL;
+        do {
+            free(path);
+            path = output_path_for(out_dir, list->paths[names[i].input], ++copy);
+        } while (output_taken(names, list->len, path));
+        fprintf(stderr, "[!] %s has the same output name as %s; writing %s\n",
+                list->paths[names[i].input], list->paths[names[first].input], path);
+        paths[names[i].input] = path;
+    }
+
+    for (size_t i = 0; i < list->len; i++) {
+        free(names[i].path);
+    }
+    free(names);
+    return paths;
+}
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// One input, with its size for largest-first scheduling
+typedef struct {
+    const char *path;
+    const char *outfile;
+    off_t size;
+} Job;
+
+// Per-worker deque of job indices. The owner pops from the head, which
+// holds its largest remaining job; thieves take from the tail, so the
+// two ends are rarely contended at the same time.
+typedef struct {
+    size_t *items;
+    size_t head;
+    size_t tail;
+    pthread_mutex_t lock;
+} JobDeque;
+
+typedef struct BatchState BatchState;
+
+typedef struct {
+    int id;
+    JobDeque queue;
+    BatchState *state;
+    pthread_t thread;
+
+    // Utilization counters, owned by this worker
+    size_t files;
+    size_t steals;
+    off_t bytes;
+    uint64_t busy_ns;
+} Worker;
+
+// State shared by the worker pool
+struct BatchState {
+    const Job *jobs;
+    const char *out_dir;
+    const AnalyzeOptions *opts;
+    Worker *workers;
+    int num_workers;
+    atomic_size_t ok;
+    atomic_size_t failed;
+};
+
+static int deque_pop_head(JobDeque *dq, size_t *job) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->head < dq->tail) {
+        *job = dq->items[dq->head++];
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static int deque_steal_tail(JobDeque *dq, size_t *job) {
+    int found = 0;
+    pthread_mutex_lock(&dq->lock);
+    if (dq->head < dq->tail) {
+        *job = dq->items[--dq->tail];
+        found = 1;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return found;
+}
+
+static void analyze_one(BatchState *state, Worker *w, const Job *job) {
+    const char *outfile = job->outfile;
+    char error[256];
+
+    uint64_t start = now_ns();
+    int rc = analyze_file(job->path, outfile, state->opts, error, sizeof(error));
+    uint64_t busy = now_ns() - start;
+
+    w->files++;
+    w->bytes += job->size;
+    w->busy_ns += busy;
+
+    // Keep each status line whole when several workers finish at once
+    flockfile(stdout);
+    if (rc == 0) {
+        printf("OK\t%s\t%s\t%.1f\n", job->path, outfile, busy / 1e6);
+        atomic_fetch_add(&state->ok, 1);
+    } else {
+        printf("FAIL\t%s\t%s\n", job->path, error);
+        atomic_fetch_add(&state->failed, 1);
+    }
+    fflush(stdout);
+    funlockfile(stdout);
+}
+
+static void *batch_worker(void *arg) {
+    Worker *w = arg;
+    BatchState *state = w->state;
+    size_t job;
+
+    for (;;) {
+        if (deque_pop_head(&w->queue, &job)) {
+            analyze_one(state, w, &state->jobs[job]);
+            continue;
+        }
+
+        // Own queue drained: steal from the other workers in turn. No new
+        // jobs are ever queued, so one empty sweep means the run is over.
+        int stole = 0;
+        for (int k = 1; k < state->num_workers && !stole; k++) {
+            Worker *victim = &state->workers[(w->id + k) % state->num_workers];
+            stole = deque_steal_tail(&victim->queue, &job);
+        }
+        if (!stole) {
+            break;
+        }
+        w->steals++;
+        analyze_one(state, w, &state->jobs[job]);
+    }
+    return NULL;
+}
+
+// Largest first; ties broken by path so runs are reproducible
+static int compare_jobs(const void *a, const void *b) {
+    const Job *ja = a;
+    const Job *jb = b;
+    if (ja->size != jb->size) {
+        return ja->size > jb->size ? -1 : 1;
+    }
+    return strcmp(ja->path, jb->path);
+}
+
+static void print_utilization(const BatchState *state, uint64_t wall_ns) {
+    fprintf(stderr, "\n[*] Batch workers (%.1f ms wall)\n", wall_ns / 1e6);
+    fprintf(stderr, "    %-6s %8s %8s %12s %12s %7s\n",
+            "worker", "files", "steals", "bytes", "busy_ms", "util");
+    for (int t = 0; t < state->num_workers; t++) {
+        const Worker *w = &state->workers[t];
+        fprintf(stderr, "    %-6d %8zu %8zu %12lld %12.1f %6.1f%%\n",
+                w->id, w->files, w->steals, (long long)w->bytes,
+                w->busy_ns / 1e6, wall_ns ? 100.0 * w->busy_ns / wall_ns : 0.0);
+    }
+
+    size_t hits, misses, names;
+    api_cache_stats(state->opts->api_cache, &hits, &misses, &names);
+    fprintf(stderr, "[*] API cache: %zu lookups, %.1f%% hits, %zu names\n",
+            hits + misses, hits + misses ? 100.0 * hits / (hits + misses) : 0.0, names);
+    print_pass_stats(stderr, state->opts->pass_stats);
+}
+
+// Analyze every input in one process on a pool of jobs worker threads
+// (jobs <= 0 means one per online CPU). Inputs are scheduled largest
+// first: sorted by size and dealt round-robin onto per-worker deques,
+// with idle workers stealing from the others so one huge sample does
+// not leave the rest of the pool waiting behind a static split.
+//
+// Emits one tab-separated status line per file on stdout, in completion
+// order, for the orchestrator:
+//   OK    <input> <output> <milliseconds>
+//   FAIL  <input> <reason>
+// followed by a final "DONE <ok> <failed>" line. Per-worker utilization,
+// the API cache hit rate and the time spent in each pass are reported on
+// stderr.
+int run_batch(const char *source, const char *out_dir, int num_workers,
+              const AnalyzeOptions *opts) {
+    PathList list = {0};
+
+    struct stat st;
+    if (stat(source, &st) != 0) {
+        perror(source);
+        return 1;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        collect_dir(&list, source);
+    } else if (collect_list_file(&list, source) != 0) {
+        return 1;
+    }
+
+    // ensure_output_dir creates the parent of a path
+    char *probe = output_path_for(out_dir, "probe", 0);
+    ensure_output_dir(probe);
+    free(probe);
+
+    char **outfiles = output_paths_for(&list, out_dir);
+    Job *jobs = calloc(list.len ? list.len : 1, sizeof(Job));
+    for (size_t i = 0; i < list.len; i++) {
+        jobs[i].path = list.paths[i];
+        jobs[i].outfile = outfiles[i];
+        jobs[i].size = stat(list.paths[i], &st) == 0 ? st.st_size : 0;
+    }
+    qsort(jobs, list.len, sizeof(Job), compare_jobs);
+
+    if (num_workers <= 0) {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        num_workers = ncpu > 0 ? (int)ncpu : 1;
+    }
+    if ((size_t)num_workers > list.len) {
+        num_workers = list.len > 0 ? (int)list.len : 1;
+    }
+
+    BatchState state = { .jobs = jobs, .out_dir = out_dir, .opts = opts, .num_workers = num_workers };
+    atomic_init(&state.ok, 0);
+    atomic_init(&state.failed, 0);
+
+    state.workers = calloc((size_t)num_workers, sizeof(Worker));
+    for (int t = 0; t < num_workers; t++) {
+        Worker *w = &state.workers[t];
+        w->id = t;
+        w->state = &state;
+        w->queue.items = malloc((list.len / num_workers + 1) * sizeof(size_t));
+        pthread_mutex_init(&w->queue.lock, NULL);
+    }
+    for (size_t i = 0; i < list.len; i++) {
+        JobDeque *dq = &state.workers[i % num_workers].queue;
+        dq->items[dq->tail++] = i;
+    }
+
+    // The calling thread is worker 0
+    uint64_t start = now_ns();
+    int started = 1;
+    for (int t = 1; t < num_workers; t++) {
+        if (pthread_create(&state.workers[t].thread, NULL, batch_worker, &state.workers[t]) != 0) {
+            break;  // Unstarted workers' queues are drained by stealing
+        }
+        started++;
+    }
+    batch_worker(&state.workers[0]);
+    for (int t = 1; t < started; t++) {
+        pthread_join(state.workers[t].thread, NULL);
+    }
+    uint64_t wall = now_ns() - start;
+
+    size_t failed = atomic_load(&state.failed);
+    printf("DONE\t%zu\t%zu\n", atomic_load(&state.ok), failed);
+    fflush(stdout);
+    print_utilization(&state, wall);
+
+    for (int t = 0; t < num_workers; t++) {
+        free(state.workers[t].queue.items);
+        pthread_mutex_destroy(&state.workers[t].queue.lock);
+    }
+    free(state.workers);
+    free(jobs);
+    for (size_t i = 0; i < list.len; i++) {
+        free(outfiles[i]);
+    }
+    free(outfiles);
+    list_free(&list);
+    return failed ? 1 : 0;
+}
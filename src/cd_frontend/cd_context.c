@@ -2,17 +2,142 @@
 #include <string.h>
 #include <stdlib.h>
 
+#define INITIAL_TABLE_CAP 64
+
+// FNV-1a, 32-bit
+static uint32_t hash_key(const char *key, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static void index_init(KeyIndex *idx, size_t cap) {
+    idx->cap = cap;
+    idx->slots = calloc(cap, sizeof(uint32_t));
+}
+
+static void index_place(KeyIndex *idx, uint32_t hash, size_t pos) {
+    size_t mask = idx->cap - 1;
+    size_t i = hash & mask;
+
+    while (idx->slots[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    idx->slots[i] = (uint32_t)(pos + 1);
+}
+
+// Grow the index until it holds len entries at load <= 1/2, then
+// re-place every symbol using its cached hash
+static void index_reserve(KeyIndex *idx, const Symbol *syms, size_t len) {
+    size_t cap = idx->cap;
+    while (len * 2 > cap) {
+        cap *= 2;
+    }
+    if (cap == idx->cap) {
+        return;
+    }
+
+    free(idx->slots);
+    index_init(idx, cap);
+    for (size_t i = 0; i < len; i++) {
+        index_place(idx, syms[i].hash, i);
+    }
+}
+
+// Keys are length-delimited views (e.g. straight into the scan buffer).
+// Returns the symbol index, or -1 if the key has not been interned.
+static int64_t intern_find(const CDContext *ctx, const char *key, size_t len, uint32_t hash) {
+    const KeyIndex *idx = &ctx->syms_index;
+    size_t mask = idx->cap - 1;
+    size_t i = hash & mask;
+
+    // Linear probing; load factor stays <= 1/2 so chains are short
+    while (idx->slots[i] != 0) {
+        uint32_t id = idx->slots[i] - 1;
+        const Symbol *sym = &ctx->syms[id];
+        if (sym->hash == hash && sym->len == len && memcmp(sym->str, key, len) == 0) {
+            return id;
+        }
+        i = (i + 1) & mask;
+    }
+    return -1;
+}
+
+// Intern with an already computed hash
+static uint32_t intern_hashed(CDContext *ctx, const char *key, size_t len, uint32_t hash) {
+    int64_t found = intern_find(ctx, key, len, hash);
+    if (found >= 0) {
+        return (uint32_t)found;
+    }
+
+    if (ctx->syms_len >= ctx->syms_cap) {
+        ctx->syms_cap *= 2;
+        ctx->syms = realloc(ctx->syms, ctx->syms_cap * sizeof(Symbol));
+    }
+
+    uint32_t id = (uint32_t)ctx->syms_len;
+    Symbol *sym = &ctx->syms[id];
+    sym->str = arena_strndup(&ctx->arena, key, len);
+    sym->len = (uint32_t)len;
+    sym->hash = hash;
+    sym->api = -1;
+
+    index_reserve(&ctx->syms_index, ctx->syms, ctx->syms_len + 1);
+    index_place(&ctx->syms_index, hash, id);
+    ctx->syms_len++;
+    return id;
+}
+
+// Count one or more calls to an interned symbol. The symbol remembers
+// its API slot, so repeat calls need no lookup at all.
+static void add_api_count(CDContext *ctx, uint32_t id, int count) {
+    Symbol *sym = &ctx->syms[id];
+
+    if (sym->api < 0) {
+        if (ctx->apis_len >= ctx->apis_cap) {
+            ctx->apis_cap *= 2;
+            ctx->apis = realloc(ctx->apis, ctx->apis_cap * sizeof(KeyCount));
+        }
+        sym->api = (int32_t)ctx->apis_len++;
+        ctx->apis[sym->api].key = sym->str;
+        ctx->apis[sym->api].count = 0;
+        ctx->apis[sym->api].sym = id;
+    }
+    ctx->apis[sym->api].count += count;
+}
+
 void ctx_init(CDContext *ctx, const char *filename) {
     ctx->filename = strdup(filename);
-    
-    ctx->apis_cap = 64;
+
+    arena_init(&ctx->arena);
+
+    ctx->syms_cap = INITIAL_TABLE_CAP;
+    ctx->syms = malloc(ctx->syms_cap * sizeof(Symbol));
+    ctx->syms_len = 0;
+    index_init(&ctx->syms_index, INITIAL_TABLE_CAP * 2);
+
+    ctx->apis_cap = INITIAL_TABLE_CAP;
     ctx->apis = calloc(ctx->apis_cap, sizeof(KeyCount));
     ctx->apis_len = 0;
-    
-    ctx->opcodes_cap = 64;
-    ctx->opcodes = calloc(ctx->opcodes_cap, sizeof(KeyCount));
+
+    memset(ctx->opcode_counts, 0, sizeof(ctx->opcode_counts));
     ctx->opcodes_len = 0;
-    
+
+    ctx->insns = NULL;
+    ctx->insns_len = 0;
+    ctx->insns_cap = 0;
+    ctx->insn_carry = 0;
+
+    ctx->func_entries = NULL;
+    ctx->func_entries_len = 0;
+    ctx->func_entries_cap = 0;
+
+    ctx->in_call = 0;
+    ctx->in_branch = 0;
+
     ctx->uses_network = 0;
     ctx->uses_fileops = 0;
     ctx->uses_registry = 0;
@@ -20,63 +145,155 @@ void ctx_init(CDContext *ctx, const char *filename) {
     ctx->uses_injection = 0;
     ctx->uses_crypto = 0;
     ctx->uses_persist = 0;
-    
+    ctx->named_apis = 0;
+    ctx->api_behaviours = 0;
+
+    memset(&ctx->cfg, 0, sizeof(ctx->cfg));
     ctx->cfg_num_blocks = 0;
     ctx->cfg_num_edges = 0;
     ctx->cfg_branch_density = 0.0;
     ctx->cfg_cyclomatic_complexity = 0.0;
+    ctx->cfg_num_functions = 0;
+    memset(&ctx->cfg_func_blocks, 0, sizeof(Distribution));
+    memset(&ctx->cfg_func_complexity, 0, sizeof(Distribution));
+    ctx->cfg_num_loops = 0;
+    ctx->cfg_max_loop_depth = 0;
+    memset(ctx->loop_opcode_counts, 0, sizeof(ctx->loop_opcode_counts));
 }
 
-void ctx_add_api(CDContext *ctx, const char *api) {
-    // Check if API already exists
-    for (size_t i = 0; i < ctx->apis_len; i++) {
-        if (strcmp(ctx->apis[i].key, api) == 0) {
-            ctx->apis[i].count++;
-            return;
-        }
+// Map a spelling to its symbol index, storing it on first sight
+uint32_t ctx_intern(CDContext *ctx, const char *str, size_t len) {
+    return intern_hashed(ctx, str, len, hash_key(str, len));
+}
+
+// Intern the upper-cased spelling, as the old `tr` cleaning pass produced
+uint32_t ctx_intern_upper(CDContext *ctx, const char *str, size_t len) {
+    char stack[128];
+    char *upper = len <= sizeof(stack) ? stack : malloc(len);
+
+    if (len == 0) {
+        return ctx_intern(ctx, str, 0);
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        char c = str[i];
+        upper[i] = (c >= 'a' && c <= 'z') ? (char)(c - ('a' - 'A')) : c;
+    }
+    uint32_t id = ctx_intern(ctx, upper, len);
+
+    if (upper != stack) {
+        free(upper);
     }
-    
-    // Add new API
-    if (ctx->apis_len >= ctx->apis_cap) {
-        ctx->apis_cap *= 2;
-        ctx->apis = realloc(ctx->apis, ctx->apis_cap * sizeof(KeyCount));
+    return id;
+}
+
+void ctx_add_api_sym(CDContext *ctx, uint32_t sym) {
+    add_api_count(ctx, sym, 1);
+}
+
+// Imports found in an image are upper-cased like the names in a raw
+// objdump listing, so one binary gives the same keys either way
+void ctx_add_api(CDContext *ctx, const char *api, size_t len) {
+    add_api_count(ctx, ctx_intern_upper(ctx, api, len), 1);
+}
+
+// List an API the binary imports even if no call to it was found
+void ctx_declare_api(CDContext *ctx, const char *api, size_t len) {
+    add_api_count(ctx, ctx_intern_upper(ctx, api, len), 0);
+}
+
+const KeyCount *ctx_find_api(const CDContext *ctx, const char *api, size_t len) {
+    int64_t id = intern_find(ctx, api, len, hash_key(api, len));
+    if (id < 0 || ctx->syms[id].api < 0) {
+        return NULL;
     }
-    
-    ctx->apis[ctx->apis_len].key = strdup(api);
-    ctx->apis[ctx->apis_len].count = 1;
-    ctx->apis_len++;
+    return &ctx->apis[ctx->syms[id].api];
 }
 
-void ctx_add_opcode(CDContext *ctx, const char *op) {
-    // Check if opcode already exists
-    for (size_t i = 0; i < ctx->opcodes_len; i++) {
-        if (strcmp(ctx->opcodes[i].key, op) == 0) {
-            ctx->opcodes[i].count++;
-            return;
+void ctx_add_insn(CDContext *ctx, uint64_t addr, uint32_t len, Mnemonic op) {
+    if (ctx->insns_len >= ctx->insns_cap) {
+        ctx->insns_cap = ctx->insns_cap ? ctx->insns_cap * 2 : INITIAL_TABLE_CAP;
+        ctx->insns = realloc(ctx->insns, ctx->insns_cap * sizeof(Insn));
+    }
+    ctx->insns[ctx->insns_len++] = (Insn){ .addr = addr, .len = len, .op = (uint16_t)op };
+}
+
+// objdump wraps long encodings onto address-only continuation lines
+void ctx_extend_insn(CDContext *ctx, uint32_t len) {
+    if (ctx->insns_len > 0) {
+        ctx->insns[ctx->insns_len - 1].len += len;
+    } else {
+        ctx->insn_carry += len;
+    }
+}
+
+void ctx_add_func_entry(CDContext *ctx, uint64_t addr) {
+    if (ctx->func_entries_len >= ctx->func_entries_cap) {
+        ctx->func_entries_cap = ctx->func_entries_cap ? ctx->func_entries_cap * 2 : INITIAL_TABLE_CAP;
+        ctx->func_entries = realloc(ctx->func_entries, ctx->func_entries_cap * sizeof(uint64_t));
+    }
+    ctx->func_entries[ctx->func_entries_len++] = addr;
+}
+
+// Fold src's counts into dst as a hash join: dst's symbol table is sized
+// for the union up front, then each src API probes dst's index with its
+// cached hash, so no key is rehashed and nothing is rescanned. Keys new
+// to dst are appended in src order, which keeps merging consecutive
+// shards of one listing equivalent to parsing it in a single pass, and
+// src's instructions are likewise appended after dst's. The CFG is not
+// merged; build_cfg builds it from the merged instructions.
+void ctx_merge(CDContext *dst, const CDContext *src) {
+    size_t need = dst->syms_len + src->apis_len;
+    if (need > dst->syms_cap) {
+        while (need > dst->syms_cap) {
+            dst->syms_cap *= 2;
         }
+        dst->syms = realloc(dst->syms, dst->syms_cap * sizeof(Symbol));
     }
-    
-    // Add new opcode
-    if (ctx->opcodes_len >= ctx->opcodes_cap) {
-        ctx->opcodes_cap *= 2;
-        ctx->opcodes = realloc(ctx->opcodes, ctx->opcodes_cap * sizeof(KeyCount));
+    index_reserve(&dst->syms_index, dst->syms, need);
+
+    for (size_t i = 0; i < src->apis_len; i++) {
+        const KeyCount *kc = &src->apis[i];
+        const Symbol *sym = &src->syms[kc->sym];
+        add_api_count(dst, intern_hashed(dst, sym->str, sym->len, sym->hash), kc->count);
     }
-    
-    ctx->opcodes[ctx->opcodes_len].key = strdup(op);
-    ctx->opcodes[ctx->opcodes_len].count = 1;
-    ctx->opcodes_len++;
+
+    for (size_t i = 0; i < src->opcodes_len; i++) {
+        Mnemonic op = src->opcode_order[i];
+        if (dst->opcode_counts[op] == 0) {
+            dst->opcode_order[dst->opcodes_len++] = (uint16_t)op;
+        }
+        dst->opcode_counts[op] += src->opcode_counts[op];
+    }
+
+    if (src->insns_len > 0 || src->insn_carry > 0) {
+        ctx_extend_insn(dst, src->insn_carry);
+        if (dst->insns_len + src->insns_len > dst->insns_cap) {
+            dst->insns_cap = dst->insns_len + src->insns_len;
+            dst->insns = realloc(dst->insns, dst->insns_cap * sizeof(Insn));
+        }
+        memcpy(dst->insns + dst->insns_len, src->insns, src->insns_len * sizeof(Insn));
+        dst->insns_len += src->insns_len;
+    }
+
+    dst->uses_network |= src->uses_network;
+    dst->uses_fileops |= src->uses_fileops;
+    dst->uses_registry |= src->uses_registry;
+    dst->uses_memory |= src->uses_memory;
+    dst->uses_injection |= src->uses_injection;
+    dst->uses_crypto |= src->uses_crypto;
+    dst->uses_persist |= src->uses_persist;
 }
 
 void ctx_free(CDContext *ctx) {
     free(ctx->filename);
-    
-    for (size_t i = 0; i < ctx->apis_len; i++) {
-        free(ctx->apis[i].key);
-    }
+
+    // Interned strings all live in the arena
+    arena_free(&ctx->arena);
+    free(ctx->syms);
+    free(ctx->syms_index.slots);
     free(ctx->apis);
-    
-    for (size_t i = 0; i < ctx->opcodes_len; i++) {
-        free(ctx->opcodes[i].key);
-    }
-    free(ctx->opcodes);
+    free(ctx->insns);
+    free(ctx->func_entries);
+    cfg_free(&ctx->cfg);
 }
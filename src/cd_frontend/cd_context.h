@@ -2,26 +2,107 @@
 #define CD_CONTEXT_H
 
 #include <stdlib.h>
+#include <stdint.h>
 
-// Key-value pair for counting APIs and opcodes
+#include "arena.h"
+#include "mnemonics.h"
+
+// Interned identifier. Each distinct spelling is stored once, in the
+// context's arena, and tokens refer to it by index into ctx->syms.
+typedef struct {
+    const char *str;
+    uint32_t len;
+    uint32_t hash;      // Cached so the index can grow without rehashing keys
+    int32_t api;        // Index into ctx->apis, or -1 if never called
+} Symbol;
+
+// Key-value pair for counting APIs
 typedef struct {
-    char *key;
+    const char *key;    // The symbol's interned string
     int count;
+    uint32_t sym;
 } KeyCount;
 
+// One instruction of an addressed (objdump) listing. Only lines that
+// carry an address are recorded; cleaned listings leave this empty.
+typedef struct {
+    uint64_t addr;
+    uint64_t target;    // Direct JMP/Jcc/CALL destination, if has_target
+    uint32_t len;       // Encoding length in bytes
+    uint16_t op;        // Mnemonic
+    uint8_t has_target;
+} Insn;
+
+// Basic-block CFG over the addressed instructions, in compressed sparse
+// row form: block b is insns[block_start[b], block_start[b + 1]) and its
+// successors are succ[succ_start[b], succ_start[b + 1]).
+typedef struct {
+    uint32_t *block_start;  // blocks + 1 entries
+    uint32_t *succ_start;   // blocks + 1 entries
+    uint32_t *succ;         // Block indices, edges entries
+    size_t blocks;
+    size_t edges;
+    uint32_t *func_entry;   // Entry block of each function, ascending
+    size_t funcs;
+} Cfg;
+
+// Largest, median and 95th-percentile value of a per-function metric
+typedef struct {
+    double max;
+    double p50;
+    double p95;
+} Distribution;
+
+// Open-addressing hash index over the Symbol array.
+// Slots hold (symbol index + 1), 0 marks an empty slot.
+typedef struct {
+    uint32_t *slots;
+    size_t cap;         // Always a power of two
+} KeyIndex;
+
 // Global context for compiler design analysis
 typedef struct {
     char *filename;
-    
-    // API and opcode tracking
+
+    // Owns every interned string; released in one go by ctx_free
+    Arena arena;
+
+    // Intern table
+    Symbol *syms;
+    size_t syms_len;
+    size_t syms_cap;
+    KeyIndex syms_index;
+
+    // API tracking, in first-called order for the IR
     KeyCount *apis;
     size_t apis_len;
     size_t apis_cap;
-    
-    KeyCount *opcodes;
+
+    // Opcodes are counted densely by mnemonic; opcode_order records
+    // first-seen order so the IR keeps listing them in insertion order
+    uint32_t opcode_counts[N_MNEMONICS];
+    uint16_t opcode_order[N_MNEMONICS];
     size_t opcodes_len;
-    size_t opcodes_cap;
-    
+
+    // Addressed instructions, in listing order
+    Insn *insns;
+    size_t insns_len;
+    size_t insns_cap;
+    // Continuation bytes read before the first instruction, which belong
+    // to the last instruction of the preceding chunk
+    uint32_t insn_carry;
+
+    // Function entry points the input declares (an image's exception
+    // directory or symbol table); build_cfg finds the rest from calls
+    uint64_t *func_entries;
+    size_t func_entries_len;
+    size_t func_entries_cap;
+
+    // Parser state: set while the operands of a CALL are being read
+    int in_call;
+    // Set until the first operand term of an addressed branch is read
+    int in_branch;
+
     // Semantic analysis flags
     int uses_network;
     int uses_fileops;
@@ -30,18 +111,55 @@ typedef struct {
     int uses_injection;
     int uses_crypto;
     int uses_persist;
-    
+
+    // What categorize_apis found in the API names, for semantic_analyze
+    int named_apis;             // Real names, not addresses or fragments
+    uint32_t api_behaviours;    // Behaviour bits of the rules' "api" lines
+
+    // Basic blocks of insns, built by build_cfg
+    Cfg cfg;
+
     // CFG metrics
     int cfg_num_blocks;
     int cfg_num_edges;
     double cfg_branch_density;
     double cfg_cyclomatic_complexity;
+
+    // Per-function CFG metrics
+    int cfg_num_functions;
+    Distribution cfg_func_blocks;
+    Distribution cfg_func_complexity;
+
+    // Natural loops of the functions, and the opcodes of the
+    // instructions inside them
+    int cfg_num_loops;
+    int cfg_max_loop_depth;
+    uint32_t loop_opcode_counts[N_MNEMONICS];
 } CDContext;
 
 // Function declarations (implementation in cd_context.c)
 void ctx_init(CDContext *ctx, const char *filename);
-void ctx_add_api(CDContext *ctx, const char *api);
-void ctx_add_opcode(CDContext *ctx, const char *op);
+uint32_t ctx_intern(CDContext *ctx, const char *str, size_t len);
+uint32_t ctx_intern_upper(CDContext *ctx, const char *str, size_t len);
+void ctx_add_api_sym(CDContext *ctx, uint32_t sym);
+void ctx_add_api(CDContext *ctx, const char *api, size_t len);
+void ctx_declare_api(CDContext *ctx, const char *api, size_t len);
+const KeyCount *ctx_find_api(const CDContext *ctx, const char *api, size_t len);
+void ctx_add_insn(CDContext *ctx, uint64_t addr, uint32_t len, Mnemonic op);
+void ctx_extend_insn(CDContext *ctx, uint32_t len);
+void ctx_add_func_entry(CDContext *ctx, uint64_t addr);
+void ctx_merge(CDContext *dst, const CDContext *src);
 void ctx_free(CDContext *ctx);
 
+// cfg_builder.c
+void build_cfg(CDContext *ctx, int threads);
+void cfg_free(Cfg *cfg);
+
+// Hot path: one increment, plus an append the first time a mnemonic is seen
+static inline void ctx_add_opcode(CDContext *ctx, Mnemonic op) {
+    if (ctx->opcode_counts[op]++ == 0) {
+        ctx->opcode_order[ctx->opcodes_len++] = (uint16_t)op;
+    }
+}
+
 #endif // CD_CONTEXT_H
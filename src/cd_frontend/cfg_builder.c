@@ -1,67 +1,458 @@
 #include "cd_context.h"
+#include "loops.h"
+#include "thread_pool.h"
+#include <stdatomic.h>
 #include <string.h>
 
-void build_cfg(CDContext *ctx) {
-    int edges = 0;
-    int blocks = 0;
-    int branches = 0;
-    
-    // Analyze opcodes to build CFG metrics
+// Open-addressing map from instruction address to index in ctx->insns.
+// Slots hold (index + 1), 0 marks an empty slot.
+typedef struct {
+    uint32_t *slots;
+    size_t mask;
+} AddrIndex;
+
+static size_t addr_hash(uint64_t addr, size_t mask) {
+    return (size_t)((addr * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+}
+
+// Load <= 1/2; the first instruction listed at an address wins
+static void addr_index_build(AddrIndex *idx, const Insn *insns, size_t n) {
+    size_t cap = 16;
+    while (cap < n * 2) {
+        cap *= 2;
+    }
+    idx->slots = calloc(cap, sizeof(uint32_t));
+    idx->mask = cap - 1;
+
+    for (size_t i = 0; i < n; i++) {
+        size_t h = addr_hash(insns[i].addr, idx->mask);
+        while (idx->slots[h] != 0 && insns[idx->slots[h] - 1].addr != insns[i].addr) {
+            h = (h + 1) & idx->mask;
+        }
+        if (idx->slots[h] == 0) {
+            idx->slots[h] = (uint32_t)(i + 1);
+        }
+    }
+}
+
+// Index of the instruction starting at addr, or -1
+static int64_t addr_index_find(const AddrIndex *idx, const Insn *insns, uint64_t addr) {
+    for (size_t h = addr_hash(addr, idx->mask); idx->slots[h] != 0; h = (h + 1) & idx->mask) {
+        if (insns[idx->slots[h] - 1].addr == addr) {
+            return idx->slots[h] - 1;
+        }
+    }
+    return -1;
+}
+
+// Whether execution runs on from insns[i] into insns[i + 1]: it is not
+// a JMP or RET, and the next instruction follows it without a gap
+static int falls_through(const Insn *insns, size_t n, size_t i) {
+    unsigned flags = mnemonic_flags[insns[i].op];
+    if ((flags & MN_F_RET) || (flags & (MN_F_JUMP | MN_F_COND)) == MN_F_JUMP) {
+        return 0;
+    }
+    return i + 1 < n && insns[i + 1].addr == insns[i].addr + insns[i].len;
+}
+
+static uint32_t find_root(uint32_t *parent, uint32_t x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// Connected components of the graph, ignoring edge direction: the P in
+// McCabe's M = E - N + 2P when a listing holds many functions
+static size_t count_components(const Cfg *cfg) {
+    uint32_t *parent = malloc(cfg->blocks * sizeof(uint32_t));
+    for (size_t b = 0; b < cfg->blocks; b++) {
+        parent[b] = (uint32_t)b;
+    }
+
+    size_t components = cfg->blocks;
+    for (size_t b = 0; b < cfg->blocks; b++) {
+        for (uint32_t e = cfg->succ_start[b]; e < cfg->succ_start[b + 1]; e++) {
+            uint32_t x = find_root(parent, (uint32_t)b), y = find_root(parent, cfg->succ[e]);
+            if (x != y) {
+                parent[x] = y;
+                components--;
+            }
+        }
+    }
+
+    free(parent);
+    return components;
+}
+
+// Marks on each instruction, set before the blocks are formed
+#define MARK_LEADER     0x1     // Starts a basic block
+#define MARK_ENTRY      0x2     // Starts a function
+#define MARK_TARGET     0x4     // A direct jump lands here
+
+// Alignment filler; "66 90" reads as xchg ax,ax
+static int is_padding(const Insn *insn) {
+    return insn->op == MN_INT3 || insn->op == MN_NOP || (insn->op == MN_XCHG && insn->len == 2);
+}
+
+// How a function opens, when nothing pads it from the code before: an
+// IBT landing pad anywhere, or saving registers or making a frame after
+// a RET (after a JMP, a PUSH is as likely a lazy PLT entry's second half)
+static int is_prologue(Mnemonic op, int after_ret) {
+    return op == MN_ENDBR64 || op == MN_ENDBR32 || (after_ret && (op == MN_PUSH || op == MN_SUB));
+}
+
+// A block starts at the first instruction, at every resolved jump or
+// call target, after every JMP, Jcc and RET, and wherever the addresses
+// skip. CALLs return, so they do not end a block. A function starts at
+// the first instruction, after a skip (a new section or symbol), at
+// every direct call target and at every entry ctx->func_entries lists.
+static void mark_instructions(const CDContext *ctx, const AddrIndex *idx, uint8_t *marks) {
+    const Insn *insns = ctx->insns;
+    size_t n = ctx->insns_len;
+
+    marks[0] = MARK_LEADER | MARK_ENTRY;
+    for (size_t i = 0; i < n; i++) {
+        unsigned flags = mnemonic_flags[insns[i].op];
+        if (i + 1 < n) {
+            if (insns[i + 1].addr != insns[i].addr + insns[i].len) {
+                marks[i + 1] |= MARK_LEADER | MARK_ENTRY;
+            } else if (flags & (MN_F_JUMP | MN_F_RET)) {
+                marks[i + 1] |= MARK_LEADER;
+            }
+        }
+        if ((flags & (MN_F_JUMP | MN_F_CALL)) && insns[i].has_target) {
+            int64_t t = addr_index_find(idx, insns, insns[i].target);
+            if (t >= 0) {
+                marks[t] |= (flags & MN_F_CALL) ? MARK_LEADER | MARK_ENTRY : MARK_LEADER | MARK_TARGET;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < ctx->func_entries_len; i++) {
+        int64_t t = addr_index_find(idx, insns, ctx->func_entries[i]);
+        if (t >= 0) {
+            marks[t] |= MARK_LEADER | MARK_ENTRY;
+        }
+    }
+
+    // Functions only reached through pointers: after a RET or JMP and
+    // any alignment padding, code that no jump lands on and that is
+    // padded or opens with a prologue instruction
+    for (size_t i = 0; i < n; i++) {
+        unsigned flags = mnemonic_flags[insns[i].op];
+        if (!(flags & MN_F_RET) && (flags & (MN_F_JUMP | MN_F_COND)) != MN_F_JUMP) {
+            continue;
+        }
+        size_t j = i + 1;
+        while (j < n && is_padding(&insns[j]) && !(marks[j] & MARK_ENTRY)) {
+            j++;
+        }
+        if (j < n && !(marks[j] & (MARK_ENTRY | MARK_TARGET)) &&
+            (j > i + 1 || is_prologue((Mnemonic)insns[j].op, (flags & MN_F_RET) != 0))) {
+            marks[j] |= MARK_LEADER | MARK_ENTRY;
+        }
+    }
+}
+
+// Form and link the blocks, in time and memory linear in the
+// instruction count. Jumps whose target is not an instruction start
+// (indirect, or into data) add no edge.
+static void build_blocks(Cfg *cfg, const Insn *insns, size_t n, const AddrIndex *idx,
+                         const uint8_t *marks) {
+    size_t blocks = 0, funcs = 0;
+    for (size_t i = 0; i < n; i++) {
+        blocks += (marks[i] & MARK_LEADER) != 0;
+        funcs += (marks[i] & MARK_ENTRY) != 0;
+    }
+
+    // Block of each leader, plus one
+    uint32_t *block_of = calloc(n, sizeof(uint32_t));
+    cfg->blocks = blocks;
+    cfg->block_start = malloc((blocks + 1) * sizeof(uint32_t));
+    cfg->funcs = funcs;
+    cfg->func_entry = malloc((funcs ? funcs : 1) * sizeof(uint32_t));
+    for (size_t i = 0, b = 0, f = 0; i < n; i++) {
+        if (marks[i] & MARK_LEADER) {
+            if (marks[i] & MARK_ENTRY) {
+                cfg->func_entry[f++] = (uint32_t)b;
+            }
+            cfg->block_start[b] = (uint32_t)i;
+            block_of[i] = (uint32_t)++b;
+        }
+    }
+    cfg->block_start[blocks] = (uint32_t)n;
+
+    // At most two successors each: the jump target and the fall-through
+    cfg->succ_start = malloc((blocks + 1) * sizeof(uint32_t));
+    cfg->succ = malloc((blocks * 2 + 1) * sizeof(uint32_t));
+    size_t edges = 0;
+    for (size_t b = 0; b < blocks; b++) {
+        size_t last = cfg->block_start[b + 1] - 1;
+        const Insn *insn = &insns[last];
+        cfg->succ_start[b] = (uint32_t)edges;
+
+        int64_t target = -1;
+        if ((mnemonic_flags[insn->op] & MN_F_JUMP) && insn->has_target) {
+            int64_t t = addr_index_find(idx, insns, insn->target);
+            if (t >= 0) {
+                target = block_of[t] - 1;
+                cfg->succ[edges++] = (uint32_t)target;
+            }
+        }
+        if (falls_through(insns, n, last) && (int64_t)b + 1 != target) {
+            cfg->succ[edges++] = (uint32_t)(b + 1);
+        }
+    }
+    cfg->succ_start[blocks] = (uint32_t)edges;
+    cfg->edges = edges;
+
+    free(block_of);
+}
+
+// Open-addressing map from block index to its number within one
+// function; keys hold (block + 1)
+typedef struct {
+    uint32_t *keys;
+    uint32_t *ids;
+    size_t mask;
+} BlockMap;
+
+// Number of block b, giving it id if it has none yet
+static uint32_t block_map_get(BlockMap *map, uint32_t b, uint32_t id) {
+    size_t h = addr_hash(b, map->mask);
+    while (map->keys[h] != 0) {
+        if (map->keys[h] == b + 1) {
+            return map->ids[h];
+        }
+        h = (h + 1) & map->mask;
+    }
+    map->keys[h] = b + 1;
+    map->ids[h] = id;
+    return id;
+}
+
+// Per-function results, filled in parallel
+typedef struct {
+    const Cfg *cfg;
+    const Insn *insns;
+    const uint8_t *is_entry;    // Per block
+    uint32_t *blocks;           // Per function
+    uint32_t *complexity;
+    uint32_t *loops;
+    uint32_t *loop_depth;
+    atomic_uint *loop_opcodes;  // N_MNEMONICS entries, shared
+} FuncMetrics;
+
+// A function is every block its entry reaches without passing through
+// another function's entry: a jump there is a tail call, not an edge.
+// Blocks shared by several functions count in each.
+static void measure_function(size_t f, void *arg) {
+    FuncMetrics *fm = arg;
+    const Cfg *cfg = fm->cfg;
+    uint32_t entry = cfg->func_entry[f];
+
+    // members doubles as the work queue and numbers the blocks locally,
+    // so the function's own edges come out in CSR order as it drains.
+    // A block has at most two successors.
+    size_t cap = 16, len = 0, edges = 0;
+    uint32_t *members = malloc(cap * sizeof(uint32_t));
+    uint32_t *local_start = malloc((cap + 1) * sizeof(uint32_t));
+    uint32_t *local_succ = malloc(cap * 2 * sizeof(uint32_t));
+    BlockMap seen = { calloc(cap * 2, sizeof(uint32_t)), malloc(cap * 2 * sizeof(uint32_t)),
+                      cap * 2 - 1 };
+    members[len++] = entry;
+    block_map_get(&seen, entry, 0);
+
+    for (size_t q = 0; q < len; q++) {
+        uint32_t b = members[q];
+        local_start[q] = (uint32_t)edges;
+        for (uint32_t e = cfg->succ_start[b]; e < cfg->succ_start[b + 1]; e++) {
+            uint32_t s = cfg->succ[e];
+            if (fm->is_entry[s] && s != entry) {
+                continue;
+            }
+            uint32_t id = block_map_get(&seen, s, (uint32_t)len);
+            local_succ[edges++] = id;
+            if (id != len) {
+                continue;
+            }
+            if (len == cap) {
+                // Keep the map at load <= 1/2 of its slots
+                cap *= 2;
+                members = realloc(members, cap * sizeof(uint32_t));
+                local_start = realloc(local_start, (cap + 1) * sizeof(uint32_t));
+                local_succ = realloc(local_succ, cap * 2 * sizeof(uint32_t));
+                free(seen.keys);
+                free(seen.ids);
+                seen.keys = calloc(cap * 2, sizeof(uint32_t));
+                seen.ids = malloc(cap * 2 * sizeof(uint32_t));
+                seen.mask = cap * 2 - 1;
+                for (size_t m = 0; m < len; m++) {
+                    block_map_get(&seen, members[m], (uint32_t)m);
+                }
+                block_map_get(&seen, s, (uint32_t)len);
+            }
+            members[len++] = s;
+        }
+    }
+    local_start[len] = (uint32_t)edges;
+
+    FuncGraph graph = { len, local_start, local_succ };
+    uint32_t *depth = malloc(len * sizeof(uint32_t));
+    uint32_t max_depth = 0;
+    fm->loops[f] = (uint32_t)find_loops(&graph, depth);
+    for (size_t m = 0; m < len; m++) {
+        if (depth[m] == 0) {
+            continue;
+        }
+        max_depth = depth[m] > max_depth ? depth[m] : max_depth;
+        uint32_t b = members[m];
+        for (uint32_t i = cfg->block_start[b]; i < cfg->block_start[b + 1]; i++) {
+            atomic_fetch_add_explicit(&fm->loop_opcodes[fm->insns[i].op], 1,
+                                      memory_order_relaxed);
+        }
+    }
+
+    fm->blocks[f] = (uint32_t)len;
+    fm->complexity[f] = (uint32_t)(edges - len + 2);
+    fm->loop_depth[f] = max_depth;
+    free(members);
+    free(local_start);
+    free(local_succ);
+    free(seen.keys);
+    free(seen.ids);
+    free(depth);
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentiles; sorts values
+static void summarize(uint32_t *values, size_t n, Distribution *d) {
+    if (n == 0) {
+        d->max = d->p50 = d->p95 = 0.0;
+        return;
+    }
+    qsort(values, n, sizeof(uint32_t), compare_u32);
+    d->max = values[n - 1];
+    d->p50 = values[(n * 50 + 99) / 100 - 1];
+    d->p95 = values[(n * 95 + 99) / 100 - 1];
+}
+
+static void measure_functions(CDContext *ctx, int threads) {
+    const Cfg *cfg = &ctx->cfg;
+    uint8_t *is_entry = calloc(cfg->blocks, 1);
+    for (size_t f = 0; f < cfg->funcs; f++) {
+        is_entry[cfg->func_entry[f]] = 1;
+    }
+
+    size_t funcs = cfg->funcs ? cfg->funcs : 1;
+    FuncMetrics fm = {
+        .cfg = cfg,
+        .insns = ctx->insns,
+        .is_entry = is_entry,
+        .blocks = malloc(funcs * sizeof(uint32_t)),
+        .complexity = malloc(funcs * sizeof(uint32_t)),
+        .loops = malloc(funcs * sizeof(uint32_t)),
+        .loop_depth = malloc(funcs * sizeof(uint32_t)),
+        .loop_opcodes = malloc(N_MNEMONICS * sizeof(atomic_uint)),
+    };
+    for (size_t op = 0; op < N_MNEMONICS; op++) {
+        atomic_init(&fm.loop_opcodes[op], 0);
+    }
+    parallel_for(cfg->funcs, threads, measure_function, &fm);
+
+    ctx->cfg_num_functions = (int)cfg->funcs;
+    ctx->cfg_num_loops = 0;
+    ctx->cfg_max_loop_depth = 0;
+    for (size_t f = 0; f < cfg->funcs; f++) {
+        ctx->cfg_num_loops += (int)fm.loops[f];
+        if ((int)fm.loop_depth[f] > ctx->cfg_max_loop_depth) {
+            ctx->cfg_max_loop_depth = (int)fm.loop_depth[f];
+        }
+    }
+    for (size_t op = 0; op < N_MNEMONICS; op++) {
+        ctx->loop_opcode_counts[op] = atomic_load(&fm.loop_opcodes[op]);
+    }
+    summarize(fm.blocks, cfg->funcs, &ctx->cfg_func_blocks);
+    summarize(fm.complexity, cfg->funcs, &ctx->cfg_func_complexity);
+    free(fm.blocks);
+    free(fm.complexity);
+    free(fm.loops);
+    free(fm.loop_depth);
+    free(fm.loop_opcodes);
+    free(is_entry);
+}
+
+// A cleaned listing has no addresses, so there is no graph to build.
+// Estimate it from the counts instead, taking every JMP, Jcc and RET to
+// end a block, and every RET to end a function: then each block has one
+// successor except that a Jcc has two and an exit has none.
+static void estimate_from_counts(CDContext *ctx) {
+    long long jumps = 0, conds = 0, rets = 0;
     for (size_t i = 0; i < ctx->opcodes_len; i++) {
-        const char *op = ctx->opcodes[i].key;
-        int count = ctx->opcodes[i].count;
-        
-        // Count basic blocks (simplified: each instruction is a potential block)
-        blocks += count;
-        
-        // Branch instructions create edges
-        if (strcmp(op, "JMP") == 0 || 
-            strcmp(op, "JZ") == 0 || 
-            strcmp(op, "JNZ") == 0 ||
-            strcmp(op, "JE") == 0 ||
-            strcmp(op, "JNE") == 0 ||
-            strcmp(op, "JG") == 0 ||
-            strcmp(op, "JL") == 0) {
-            branches += count;
-            edges += count * 2; // conditional branches create 2 edges
-        }
-        
-        // CALL creates edges (call + return)
-        if (strcmp(op, "CALL") == 0) {
-            edges += count * 2;
-        }
-        
-        // RET creates edge back
-        if (strcmp(op, "RET") == 0) {
-            edges += count;
-        }
-        
-        // Direct flow (sequential) creates edges
-        if (strcmp(op, "MOV") == 0 ||
-            strcmp(op, "PUSH") == 0 ||
-            strcmp(op, "POP") == 0 ||
-            strcmp(op, "ADD") == 0 ||
-            strcmp(op, "SUB") == 0 ||
-            strcmp(op, "XOR") == 0) {
-            edges += count;
-        }
-    }
-    
-    ctx->cfg_num_blocks = blocks > 0 ? blocks : 1;
-    ctx->cfg_num_edges = edges > 0 ? edges : 0;
-    
-    // Calculate metrics
-    if (ctx->cfg_num_blocks > 0) {
-        ctx->cfg_branch_density = (double)branches / ctx->cfg_num_blocks;
-    } else {
-        ctx->cfg_branch_density = 0.0;
-    }
-    
-    // Cyclomatic complexity: M = E - N + 2P (P=1 for single program)
-    ctx->cfg_cyclomatic_complexity = (double)(ctx->cfg_num_edges - ctx->cfg_num_blocks + 2);
-    
-    // Ensure non-negative complexity
-    if (ctx->cfg_cyclomatic_complexity < 1.0) {
-        ctx->cfg_cyclomatic_complexity = 1.0;
+        Mnemonic op = ctx->opcode_order[i];
+        unsigned flags = mnemonic_flags[op];
+        long long count = ctx->opcode_counts[op];
+        if (flags & MN_F_JUMP) {
+            jumps += count;
+            conds += (flags & MN_F_COND) ? count : 0;
+        }
+        if (flags & MN_F_RET) {
+            rets += count;
+        }
     }
+
+    long long exits = rets > 0 ? rets : 1;
+    long long blocks = jumps + rets + 1;
+    ctx->cfg_num_blocks = (int)blocks;
+    ctx->cfg_num_edges = (int)(blocks - exits + conds);
+    ctx->cfg_branch_density = (double)jumps / (double)blocks;
+    ctx->cfg_cyclomatic_complexity = (double)(conds + exits);
+}
+
+// Blocks, edges and functions of ctx->insns, with the per-function
+// metrics computed on up to threads threads
+void build_cfg(CDContext *ctx, int threads) {
+    cfg_free(&ctx->cfg);
+    if (ctx->insns_len == 0) {
+        estimate_from_counts(ctx);
+        return;
+    }
+
+    Cfg *cfg = &ctx->cfg;
+    AddrIndex idx;
+    addr_index_build(&idx, ctx->insns, ctx->insns_len);
+    uint8_t *marks = calloc(ctx->insns_len, 1);
+    mark_instructions(ctx, &idx, marks);
+    build_blocks(cfg, ctx->insns, ctx->insns_len, &idx, marks);
+    free(marks);
+    free(idx.slots);
+
+    size_t branches = 0;
+    for (size_t i = 0; i < ctx->insns_len; i++) {
+        branches += (mnemonic_flags[ctx->insns[i].op] & MN_F_JUMP) != 0;
+    }
+
+    ctx->cfg_num_blocks = (int)cfg->blocks;
+    ctx->cfg_num_edges = (int)cfg->edges;
+    ctx->cfg_branch_density = (double)branches / (double)cfg->blocks;
+
+    // Cyclomatic complexity: M = E - N + 2P, summed over the components
+    ctx->cfg_cyclomatic_complexity =
+        (double)cfg->edges - (double)cfg->blocks + 2.0 * (double)count_components(cfg);
+
+    measure_functions(ctx, threads);
+}
+
+void cfg_free(Cfg *cfg) {
+    free(cfg->block_start);
+    free(cfg->succ_start);
+    free(cfg->succ);
+    free(cfg->func_entry);
+    memset(cfg, 0, sizeof(*cfg));
 }
@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "disasm.h"
+#include "x86_decode.h"
+
+// objdump's defaults: runs of at least SKIP_ZEROES zero bytes print as
+// "...", as do shorter runs that end the range, and x86 lines list at
+// most BYTES_PER_LINE encoding bytes before wrapping
+#define SKIP_ZEROES         8
+#define SKIP_ZEROES_AT_END  3
+#define BYTES_PER_LINE      7
+
+// A CALL or JMP through an IAT slot: ctx->insns[insn] uses imp
+typedef struct {
+    size_t insn;
+    const ImageImport *imp;
+} IatRef;
+
+typedef struct {
+    IatRef *refs;
+    size_t len;
+    size_t cap;
+} IatRefs;
+
+// A "jmp [slot]" stub, with whether any direct CALL/JMP lands on it
+typedef struct {
+    uint64_t addr;
+    const ImageImport *imp;
+    int targeted;
+} Thunk;
+
+// Number of zero bytes to skip at data[0, len), or 0 to decode here
+static size_t zero_run(const uint8_t *data, size_t len) {
+    size_t z = 0;
+    while (z < len && data[z] == 0) {
+        z++;
+    }
+    if (z == len) {
+        return z >= SKIP_ZEROES || z < SKIP_ZEROES_AT_END ? z : 0;
+    }
+    // Mid-range runs are skipped in multiples of 4 so a following
+    // instruction that happens to start with a zero byte is kept
+    return z >= SKIP_ZEROES ? z & ~(size_t)3 : 0;
+}
+
+// Linear sweep; with img, CALLs and JMPs through its IAT go to refs
+static void sweep(CDContext *ctx, const uint8_t *data, size_t len, uint64_t addr, int bits,
+                  const Image *img, IatRefs *refs) {
+    size_t off = 0;
+    while (off < len) {
+        size_t skip = zero_run(data + off, len - off);
+        if (skip > 0) {
+            off += skip;
+            continue;
+        }
+
+        X86Insn insn;
+        size_t n = x86_decode(data + off, len - off, addr + off, bits, &insn);
+
+        if (insn.op >= 0) {
+            ctx_add_opcode(ctx, (Mnemonic)insn.op);
+            ctx_add_insn(ctx, addr + off, (uint32_t)n, (Mnemonic)insn.op);
+            // As in a listing, only jumps and calls record their target
+            if (insn.has_target && (mnemonic_flags[insn.op] & (MN_F_JUMP | MN_F_CALL))) {
+                Insn *rec = &ctx->insns[ctx->insns_len - 1];
+                rec->target = insn.target;
+                rec->has_target = 1;
+            }
+            // Inside a PLT entry the jump belongs to the entry's callers
+            const ImageImport *imp;
+            if (img && insn.has_mem && (insn.op == MN_CALL || insn.op == MN_JMP) &&
+                (imp = image_find_import(img, insn.mem)) != NULL &&
+                !image_find_stub(img, addr + off)) {
+                if (refs->len >= refs->cap) {
+                    refs->cap = refs->cap ? refs->cap * 2 : 256;
+                    refs->refs = realloc(refs->refs, refs->cap * sizeof(IatRef));
+                }
+                refs->refs[refs->len++] = (IatRef){ ctx->insns_len - 1, imp };
+            }
+        } else if (insn.op == X86_OP_PREFIX) {
+            // A bare prefix line reads as an address-only continuation
+            ctx_extend_insn(ctx, (uint32_t)n);
+        } else if (n > BYTES_PER_LINE) {
+            // "(bad)" and unknown names are not recorded, but their
+            // wrapped continuation lines extend the previous instruction
+            ctx_extend_insn(ctx, (uint32_t)(n - BYTES_PER_LINE));
+        }
+        off += n;
+    }
+}
+
+void disasm_range(CDContext *ctx, const uint8_t *data, size_t len, uint64_t addr, int bits) {
+    sweep(ctx, data, len, addr, bits, NULL, NULL);
+}
+
+static void add_import_api(CDContext *ctx, const ImageImport *imp, int called) {
+    char ordinal[280];
+    const char *name = imp->name;
+    size_t len = imp->name_len;
+
+    if (!name) {
+        // By ordinal only: "WS2_32.dll#23"
+        int n = snprintf(ordinal, sizeof(ordinal), "%.*s#%u",
+                         (int)(imp->dll_len < 255 ? imp->dll_len : 255), imp->dll, imp->ordinal);
+        name = ordinal;
+        len = (size_t)n;
+    }
+    if (called) {
+        ctx_add_api(ctx, name, len);
+    } else {
+        ctx_declare_api(ctx, name, len);
+    }
+}
+
+static int compare_thunks(const void *a, const void *b) {
+    uint64_t x = ((const Thunk *)a)->addr, y = ((const Thunk *)b)->addr;
+    return (x > y) - (x < y);
+}
+
+static Thunk *find_thunk(Thunk *thunks, size_t len, uint64_t addr) {
+    Thunk key = { .addr = addr };
+    return bsearch(&key, thunks, len, sizeof(Thunk), compare_thunks);
+}
+
+// Attribute calls to imports, in call order: "call [slot]", and direct
+// calls or tail jumps to a "jmp [slot]" stub or a PLT entry (which is
+// then not a call itself). A "jmp [slot]" nothing branches to is a tail
+// call.
+static void count_import_calls(CDContext *ctx, const Image *img, const IatRefs *refs) {
+    Thunk *thunks = malloc((refs->len ? refs->len : 1) * sizeof(Thunk));
+    size_t thunks_len = 0;
+    for (size_t i = 0; i < refs->len; i++) {
+        const Insn *insn = &ctx->insns[refs->refs[i].insn];
+        if (insn->op == MN_JMP) {
+            thunks[thunks_len++] = (Thunk){ insn->addr, refs->refs[i].imp, 0 };
+        }
+    }
+    qsort(thunks, thunks_len, sizeof(Thunk), compare_thunks);
+
+    for (size_t i = 0; i < ctx->insns_len && thunks_len > 0; i++) {
+        const Insn *insn = &ctx->insns[i];
+        Thunk *thunk;
+        if (insn->has_target && (insn->op == MN_CALL || insn->op == MN_JMP) &&
+            (thunk = find_thunk(thunks, thunks_len, insn->target)) != NULL) {
+            thunk->targeted = 1;
+        }
+    }
+
+    size_t next = 0;
+    for (size_t i = 0; i < ctx->insns_len; i++) {
+        const Insn *insn = &ctx->insns[i];
+        Thunk *thunk;
+        if (next < refs->len && refs->refs[next].insn == i) {
+            const ImageImport *imp = refs->refs[next++].imp;
+            if (insn->op == MN_CALL ||
+                !find_thunk(thunks, thunks_len, insn->addr)->targeted) {
+                add_import_api(ctx, imp, 1);
+            }
+        } else if (insn->has_target && (insn->op == MN_CALL || insn->op == MN_JMP)) {
+            const ImageStub *stub;
+            if (thunks_len > 0 &&
+                (thunk = find_thunk(thunks, thunks_len, insn->target)) != NULL) {
+                add_import_api(ctx, thunk->imp, 1);
+            } else if ((stub = image_find_stub(img, insn->target)) != NULL) {
+                add_import_api(ctx, stub->imp, 1);
+            }
+        }
+    }
+    free(thunks);
+}
+
+// Sweep sec as objdump does: afresh from each symbol inside it
+static void sweep_section(CDContext *ctx, const Image *img, const ImageSection *sec,
+                          IatRefs *refs) {
+    // First symbol past the section start
+    size_t lo = 0, hi = img->symbols_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (img->symbols[mid] <= sec->vaddr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    size_t off = 0;
+    while (off < sec->size) {
+        size_t end = sec->size;
+        if (lo < img->symbols_len && img->symbols[lo] - sec->vaddr < sec->size) {
+            end = (size_t)(img->symbols[lo++] - sec->vaddr);
+        }
+        sweep(ctx, sec->data + off, end - off, sec->vaddr + off, img->bits, img, refs);
+        off = end;
+    }
+}
+
+void disasm_image(CDContext *ctx, const Image *img) {
+    IatRefs refs = { 0 };
+
+    for (size_t i = 0; i < img->sections_len; i++) {
+        const ImageSection *sec = &img->sections[i];
+        if (sec->exec) {
+            sweep_section(ctx, img, sec, &refs);
+        }
+    }
+
+    count_import_calls(ctx, img, &refs);
+    free(refs.refs);
+
+    // Imports no call was found to still belong to the API list
+    for (size_t i = 0; i < img->imports_len; i++) {
+        add_import_api(ctx, &img->imports[i], 0);
+    }
+
+    if (img->entry != 0) {
+        ctx_add_func_entry(ctx, img->entry);
+    }
+    for (size_t i = 0; i < img->functions_len; i++) {
+        ctx_add_func_entry(ctx, img->functions[i]);
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef DISASM_H
+#define DISASM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cd_context.h"
+#include "image.h"
+
+// Linear-sweep [data, data + len), located at addr, into ctx: the same
+// opcode counts and Insn records parsing `objdump -d` of the range gives.
+// Like objdump, a range is decoded independently of its neighbours, so
+// callers split sections wherever objdump would restart (e.g. symbols).
+void disasm_range(CDContext *ctx, const uint8_t *data, size_t len, uint64_t addr, int bits);
+
+// Disassemble every code section of img, in section table order. Calls
+// through its import table, directly or via a "jmp [slot]" stub or PLT
+// entry, count as calls to the imported function, and every import is
+// listed in ctx->apis, with a count of 0 if no call to it was found.
+// The entry point and the functions img records go to ctx->func_entries.
+void disasm_image(CDContext *ctx, const Image *img);
+
+#endif // DISASM_H
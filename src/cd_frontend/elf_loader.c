@@ -0,0 +1,480 @@
+#include "image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ELF_CLASS32             1
+#define ELF_CLASS64             2
+#define ELF_DATA_LSB            1
+#define ELF_TYPE_EXEC           2
+#define ELF_TYPE_DYN            3
+#define ELF_MACHINE_386         3
+#define ELF_MACHINE_X86_64      62
+#define ELF_SHT_SYMTAB          2
+#define ELF_SHT_RELA            4
+#define ELF_SHT_NOBITS          8
+#define ELF_SHT_REL             9
+#define ELF_SHT_DYNSYM          11
+#define ELF_SHF_EXECINSTR       0x4
+#define ELF_SHN_UNDEF           0
+#define ELF_SHN_XINDEX          0xFFFF
+#define ELF_STT_FUNC            2
+#define ELF_STT_SECTION         3
+#define ELF_STT_FILE            4
+#define ELF_PT_LOAD             1
+#define ELF_PF_X                0x1
+// Same numbers for R_386_* and R_X86_64_*
+#define ELF_R_GLOB_DAT          6
+#define ELF_R_JUMP_SLOT         7
+
+// Default PLT entry size. .plt.got may be 8 bytes, and says so in
+// sh_entsize; i386 ld writes 4 there, shorter than any entry can be.
+#define ELF_PLT_ENTRY_SIZE      16
+#define ELF_PLT_MIN_ENTRY_SIZE  8
+
+// Sanity bound for corrupt symbol and relocation tables
+#define ELF_MAX_ENTRIES         (1u << 20)
+
+// Field offsets that differ between ELF32 and ELF64
+typedef struct {
+    size_t wide;        // Address size: 4 or 8
+    size_t ehdr_size;
+    size_t shdr_size;
+    size_t phdr_size;
+    size_t sym_size;
+    size_t rel_size;
+    size_t rela_size;
+} ElfLayout;
+
+static const ElfLayout layout32 = { 4, 52, 40, 32, 16, 8, 12 };
+static const ElfLayout layout64 = { 8, 64, 64, 56, 24, 16, 24 };
+
+typedef struct {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint64_t entsize;
+} ElfSection;
+
+typedef struct {
+    uint32_t name;
+    uint8_t type;
+    uint16_t shndx;
+    uint64_t value;
+} ElfSymbol;
+
+// The loader's view of one file while the Image is built
+typedef struct {
+    Image *img;
+    const uint8_t *data;
+    size_t len;
+    const ElfLayout *lay;
+    ElfSection *shdrs;
+    size_t shnum;
+    size_t symbols_cap;
+    size_t functions_cap;
+} ElfFile;
+
+static uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t read_u64(const uint8_t *p) {
+    return read_u32(p) | (uint64_t)read_u32(p + 4) << 32;
+}
+
+static uint64_t read_addr(const ElfLayout *lay, const uint8_t *p) {
+    return lay->wide == 8 ? read_u64(p) : read_u32(p);
+}
+
+static void read_section(const ElfLayout *lay, const uint8_t *p, ElfSection *sh) {
+    size_t w = lay->wide;
+    sh->name = read_u32(p);
+    sh->type = read_u32(p + 4);
+    sh->flags = read_addr(lay, p + 8);
+    sh->addr = read_addr(lay, p + 8 + w);
+    sh->offset = read_addr(lay, p + 8 + 2 * w);
+    sh->size = read_addr(lay, p + 8 + 3 * w);
+    sh->link = read_u32(p + 8 + 4 * w);
+    sh->entsize = read_addr(lay, p + 16 + 5 * w);
+}
+
+static void read_symbol(const ElfLayout *lay, const uint8_t *p, ElfSymbol *sym) {
+    sym->name = read_u32(p);
+    if (lay->wide == 8) {
+        sym->type = p[4] & 0xF;
+        sym->shndx = read_u16(p + 6);
+        sym->value = read_u64(p + 8);
+    } else {
+        sym->value = read_u32(p + 4);
+        sym->type = p[12] & 0xF;
+        sym->shndx = read_u16(p + 14);
+    }
+}
+
+// The file contents of section i, or NULL if it has none in the file
+static const uint8_t *section_data(const ElfFile *elf, size_t i, size_t *size) {
+    if (i >= elf->shnum || elf->shdrs[i].type == ELF_SHT_NOBITS) {
+        return NULL;
+    }
+    const ElfSection *sh = &elf->shdrs[i];
+    if (sh->offset > elf->len) {
+        return NULL;
+    }
+    *size = sh->size < elf->len - sh->offset ? (size_t)sh->size : elf->len - (size_t)sh->offset;
+    return elf->data + sh->offset;
+}
+
+// The string at off in string table section strtab, bounded by the table
+static const char *string_at(const ElfFile *elf, size_t strtab, uint32_t off, uint32_t *len) {
+    size_t size;
+    const uint8_t *tab = section_data(elf, strtab, &size);
+    if (!tab || off >= size) {
+        *len = 0;
+        return "";
+    }
+    const uint8_t *nul = memchr(tab + off, 0, size - off);
+    *len = (uint32_t)(nul ? (size_t)(nul - tab - off) : size - off);
+    return (const char *)tab + off;
+}
+
+static void add_symbol(ElfFile *elf, uint64_t addr) {
+    Image *img = elf->img;
+    if (img->symbols_len >= elf->symbols_cap) {
+        elf->symbols_cap = elf->symbols_cap ? elf->symbols_cap * 2 : 256;
+        img->symbols = realloc(img->symbols, elf->symbols_cap * sizeof(uint64_t));
+    }
+    img->symbols[img->symbols_len++] = addr;
+}
+
+static void add_function(ElfFile *elf, uint64_t addr) {
+    Image *img = elf->img;
+    if (img->functions_len >= elf->functions_cap) {
+        elf->functions_cap = elf->functions_cap ? elf->functions_cap * 2 : 256;
+        img->functions = realloc(img->functions, elf->functions_cap * sizeof(uint64_t));
+    }
+    img->functions[img->functions_len++] = addr;
+}
+
+static int compare_addrs(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int compare_slots(const void *a, const void *b) {
+    uint64_t x = ((const ImageImport *)a)->slot, y = ((const ImageImport *)b)->slot;
+    return (x > y) - (x < y);
+}
+
+static int compare_stubs(const void *a, const void *b) {
+    uint64_t x = ((const ImageStub *)a)->addr, y = ((const ImageStub *)b)->addr;
+    return (x > y) - (x < y);
+}
+
+// objdump restarts decoding at every symbol defined in a code section.
+// It reads .symtab, or .dynsym when the file is stripped. Function
+// symbols are also kept as function entries.
+static void load_symbols(ElfFile *elf) {
+    size_t table = elf->shnum;
+    for (size_t i = 0; i < elf->shnum; i++) {
+        if (elf->shdrs[i].type == ELF_SHT_SYMTAB) {
+            table = i;
+            break;
+        }
+        if (elf->shdrs[i].type == ELF_SHT_DYNSYM && table == elf->shnum) {
+            table = i;
+        }
+    }
+
+    size_t size;
+    const uint8_t *syms = section_data(elf, table, &size);
+    if (!syms) {
+        return;
+    }
+    size_t count = size / elf->lay->sym_size;
+    for (size_t i = 1; i < count && i < ELF_MAX_ENTRIES; i++) {
+        ElfSymbol sym;
+        uint32_t name_len;
+        read_symbol(elf->lay, syms + i * elf->lay->sym_size, &sym);
+        string_at(elf, elf->shdrs[table].link, sym.name, &name_len);
+        if (name_len == 0 || sym.type == ELF_STT_SECTION || sym.type == ELF_STT_FILE ||
+            sym.shndx >= elf->shnum || !elf->img->sections[sym.shndx].exec) {
+            continue;
+        }
+        add_symbol(elf, sym.value);
+        if (sym.type == ELF_STT_FUNC) {
+            add_function(elf, sym.value);
+        }
+    }
+}
+
+// Functions the file imports: GOT slots the dynamic linker fills with an
+// undefined symbol's address, lazily through the PLT (JUMP_SLOT) or at
+// load time (GLOB_DAT, as -fno-plt calls use)
+static void load_imports(ElfFile *elf) {
+    const ElfLayout *lay = elf->lay;
+    size_t cap = 0;
+
+    for (size_t i = 0; i < elf->shnum; i++) {
+        const ElfSection *sh = &elf->shdrs[i];
+        if ((sh->type != ELF_SHT_REL && sh->type != ELF_SHT_RELA) ||
+            sh->link >= elf->shnum || elf->shdrs[sh->link].type != ELF_SHT_DYNSYM) {
+            continue;
+        }
+        size_t rels_size, syms_size;
+        const uint8_t *rels = section_data(elf, i, &rels_size);
+        const uint8_t *syms = section_data(elf, sh->link, &syms_size);
+        if (!rels || !syms) {
+            continue;
+        }
+        size_t entry = sh->type == ELF_SHT_RELA ? lay->rela_size : lay->rel_size;
+        size_t strtab = elf->shdrs[sh->link].link;
+
+        for (size_t r = 0; r < rels_size / entry && r < ELF_MAX_ENTRIES; r++) {
+            const uint8_t *rel = rels + r * entry;
+            uint64_t info = read_addr(lay, rel + lay->wide);
+            uint32_t type = lay->wide == 8 ? (uint32_t)info : (uint8_t)info;
+            uint64_t index = lay->wide == 8 ? info >> 32 : info >> 8;
+            if ((type != ELF_R_JUMP_SLOT && type != ELF_R_GLOB_DAT) || index == 0 ||
+                index >= syms_size / lay->sym_size) {
+                continue;
+            }
+
+            ElfSymbol sym;
+            read_symbol(lay, syms + index * lay->sym_size, &sym);
+            // GLOB_DAT also covers imported data such as stdout
+            if (sym.shndx != ELF_SHN_UNDEF ||
+                (type == ELF_R_GLOB_DAT && sym.type != ELF_STT_FUNC)) {
+                continue;
+            }
+            ImageImport imp = { .slot = read_addr(lay, rel) };
+            imp.name = string_at(elf, strtab, sym.name, &imp.name_len);
+            if (imp.name_len == 0) {
+                continue;
+            }
+
+            if (elf->img->imports_len >= cap) {
+                cap = cap ? cap * 2 : 64;
+                elf->img->imports = realloc(elf->img->imports, cap * sizeof(ImageImport));
+            }
+            elf->img->imports[elf->img->imports_len++] = imp;
+        }
+    }
+
+    if (elf->img->imports_len > 1) {
+        qsort(elf->img->imports, elf->img->imports_len, sizeof(ImageImport), compare_slots);
+    }
+}
+
+// The GOT slot a PLT entry jumps through, or 0 if it is not a stub
+// ("jmp [slot]", or "jmp [ebx+off]" in i386 PIC code, where ebx holds
+// the GOT), optionally behind endbr and a bnd prefix
+static uint64_t plt_slot(const uint8_t *p, size_t len, uint64_t addr, int bits, uint64_t got) {
+    size_t i = 0;
+    if (len >= 4 && p[0] == 0xF3 && p[1] == 0x0F && p[2] == 0x1E && (p[3] & 0xFE) == 0xFA) {
+        i = 4;
+    }
+    if (i < len && p[i] == 0xF2) {
+        i++;
+    }
+    if (len < i + 6 || p[i] != 0xFF) {
+        return 0;
+    }
+    uint32_t disp = read_u32(p + i + 2);
+    if (p[i + 1] == 0x25) {
+        return bits == 64 ? addr + i + 6 + (uint64_t)(int64_t)(int32_t)disp : disp;
+    }
+    if (p[i + 1] == 0xA3 && bits == 32) {
+        return (uint32_t)(got + disp);
+    }
+    return 0;
+}
+
+// Resolve PLT entries to the imports they jump to, as the name@plt
+// symbols objdump synthesises; each is also a point it restarts at
+static void load_stubs(ElfFile *elf, uint64_t got) {
+    Image *img = elf->img;
+    size_t cap = 0;
+
+    for (size_t i = 0; i < elf->shnum && img->imports_len > 0; i++) {
+        const ImageSection *sec = &img->sections[i];
+        if (!sec->exec || strncmp(sec->name, ".plt", 4) != 0) {
+            continue;
+        }
+        uint64_t entry = elf->shdrs[i].entsize;
+        if (entry < ELF_PLT_MIN_ENTRY_SIZE) {
+            entry = ELF_PLT_ENTRY_SIZE;
+        }
+        for (uint64_t off = 0; off < sec->size; off += entry) {
+            size_t avail = sec->size - (size_t)off;
+            uint64_t slot = plt_slot(sec->data + off, avail < entry ? avail : (size_t)entry,
+                                     sec->vaddr + off, img->bits, got);
+            const ImageImport *imp = slot ? image_find_import(img, slot) : NULL;
+            if (!imp) {
+                continue;
+            }
+            if (img->stubs_len >= cap) {
+                cap = cap ? cap * 2 : 64;
+                img->stubs = realloc(img->stubs, cap * sizeof(ImageStub));
+            }
+            img->stubs[img->stubs_len++] = (ImageStub){ sec->vaddr + off, (uint32_t)entry, imp };
+            add_symbol(elf, sec->vaddr + off);
+        }
+    }
+
+    if (img->stubs_len > 1) {
+        qsort(img->stubs, img->stubs_len, sizeof(ImageStub), compare_stubs);
+    }
+}
+
+// A file without section headers: take the executable segments instead
+static int load_segments(ElfFile *elf, uint64_t phoff, size_t phnum) {
+    const ElfLayout *lay = elf->lay;
+    Image *img = elf->img;
+    if (phoff > elf->len || (elf->len - phoff) / lay->phdr_size < phnum) {
+        return -1;
+    }
+
+    img->sections = calloc(phnum ? phnum : 1, sizeof(ImageSection));
+    for (size_t i = 0; i < phnum; i++) {
+        const uint8_t *ph = elf->data + phoff + i * lay->phdr_size;
+        size_t w = lay->wide;
+        uint32_t type = read_u32(ph);
+        uint32_t flags = read_u32(w == 8 ? ph + 4 : ph + 24);
+        uint64_t offset = read_addr(lay, ph + (w == 8 ? 8 : 4));
+        uint64_t vaddr = read_addr(lay, ph + (w == 8 ? 16 : 8));
+        uint64_t filesz = read_addr(lay, ph + (w == 8 ? 32 : 16));
+        if (type != ELF_PT_LOAD || !(flags & ELF_PF_X) || offset > elf->len) {
+            continue;
+        }
+
+        ImageSection *sec = &img->sections[img->sections_len++];
+        memcpy(sec->name, "LOAD", 5);
+        sec->vaddr = vaddr;
+        sec->data = elf->data + offset;
+        sec->size = filesz < elf->len - offset ? (size_t)filesz : elf->len - (size_t)offset;
+        sec->exec = sec->size > 0;
+    }
+    return 0;
+}
+
+// ELF32 and ELF64 executables and shared objects (i386 and x86-64).
+// Code comes from the SHF_EXECINSTR sections, split at symbols the way
+// `objdump -d` splits them, and PLT calls resolve through the dynamic
+// relocations to the imported symbol names.
+int elf_load(Image *img, const uint8_t *data, size_t len, char *error, size_t error_len) {
+    const ElfLayout *lay = data[4] == ELF_CLASS64 ? &layout64 :
+                           data[4] == ELF_CLASS32 ? &layout32 : NULL;
+    if (!lay || data[5] != ELF_DATA_LSB) {
+        snprintf(error, error_len, "unsupported ELF class %u / data encoding %u", data[4], data[5]);
+        return -1;
+    }
+    if (len < lay->ehdr_size) {
+        snprintf(error, error_len, "truncated ELF header");
+        return -1;
+    }
+
+    size_t w = lay->wide;
+    uint16_t type = read_u16(data + 16);
+    uint16_t machine = read_u16(data + 18);
+    uint64_t entry = read_addr(lay, data + 24);
+    uint64_t phoff = read_addr(lay, data + 24 + w);
+    uint64_t shoff = read_addr(lay, data + 24 + 2 * w);
+    size_t phnum = read_u16(data + 28 + 3 * w + 4);
+    size_t shnum = read_u16(data + 28 + 3 * w + 8);
+    size_t shstrndx = read_u16(data + 28 + 3 * w + 10);
+
+    if (type != ELF_TYPE_EXEC && type != ELF_TYPE_DYN) {
+        snprintf(error, error_len, "unsupported ELF type %u (not an executable or shared object)",
+                 type);
+        return -1;
+    }
+    if ((machine != ELF_MACHINE_386 || w != 4) && (machine != ELF_MACHINE_X86_64 || w != 8)) {
+        snprintf(error, error_len, "unsupported ELF machine %u", machine);
+        return -1;
+    }
+    img->format = IMAGE_ELF;
+    img->bits = (int)w * 8;
+    img->entry = entry;
+
+    ElfFile elf = { img, data, len, lay, NULL, 0, 0, 0 };
+
+    // Section counts past 0xFF00 live in the first section header
+    if (shoff != 0 && shoff <= len && len - shoff >= lay->shdr_size) {
+        ElfSection first;
+        read_section(lay, data + shoff, &first);
+        if (shnum == 0) {
+            shnum = (size_t)first.size;
+        }
+        if (shstrndx == ELF_SHN_XINDEX) {
+            shstrndx = first.link;
+        }
+    }
+
+    if (shoff == 0 || shnum == 0) {
+        if (load_segments(&elf, phoff, phnum) != 0) {
+            snprintf(error, error_len, "truncated ELF program header table");
+            return -1;
+        }
+        return 0;
+    }
+    if (shoff > len || (len - shoff) / lay->shdr_size < shnum) {
+        snprintf(error, error_len, "truncated ELF section table");
+        return -1;
+    }
+
+    elf.shdrs = malloc(shnum * sizeof(ElfSection));
+    elf.shnum = shnum;
+    img->sections = calloc(shnum, sizeof(ImageSection));
+    img->sections_len = shnum;
+    uint64_t got = 0;
+    for (size_t i = 0; i < shnum; i++) {
+        ElfSection *sh = &elf.shdrs[i];
+        read_section(lay, data + shoff + i * lay->shdr_size, sh);
+    }
+    for (size_t i = 0; i < shnum; i++) {
+        const ElfSection *sh = &elf.shdrs[i];
+        ImageSection *sec = &img->sections[i];
+        uint32_t name_len;
+        const char *name = string_at(&elf, shstrndx, sh->name, &name_len);
+        memcpy(sec->name, name, name_len < 8 ? name_len : 8);
+        sec->vaddr = sh->addr;
+        sec->data = section_data(&elf, i, &sec->size);
+        if (!sec->data) {
+            sec->size = 0;
+        }
+        sec->exec = (sh->flags & ELF_SHF_EXECINSTR) && sec->size > 0;
+
+        // i386 PIC stubs address the GOT from _GLOBAL_OFFSET_TABLE_,
+        // the start of .got.plt
+        if ((name_len == 8 && memcmp(name, ".got.plt", 8) == 0) ||
+            (got == 0 && name_len == 4 && memcmp(name, ".got", 4) == 0)) {
+            got = sh->addr;
+        }
+    }
+
+    load_symbols(&elf);
+    load_imports(&elf);
+    load_stubs(&elf, got);
+    free(elf.shdrs);
+
+    if (img->symbols_len > 1) {
+        qsort(img->symbols, img->symbols_len, sizeof(uint64_t), compare_addrs);
+        size_t n = 1;
+        for (size_t i = 1; i < img->symbols_len; i++) {
+            if (img->symbols[i] != img->symbols[n - 1]) {
+                img->symbols[n++] = img->symbols[i];
+            }
+        }
+        img->symbols_len = n;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#ifndef FRONTEND_H
+#define FRONTEND_H
+
+#include <stddef.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include "api_cache.h"
+#include "cd_context.h"
+#include "input_buffer.h"
+#include "rules.h"
+#include "scanner.h"
+
+// Passes of analyze_file, registered in main.c
+typedef enum { PASS_PARSE, PASS_APIS, PASS_CFG, PASS_SEMANTIC, PASS_IR, N_PASSES } PassId;
+
+#define PASS_BIT(pass) (1u << (pass))
+#define ALL_PASSES (PASS_BIT(N_PASSES) - 1)
+
+// Time spent in each pass, summed over every file analyzed. CPU time is
+// that of the thread running the pass; helper threads (--cfg-threads)
+// are not counted.
+typedef struct {
+    atomic_ullong runs[N_PASSES];
+    atomic_ullong wall_ns[N_PASSES];
+    atomic_ullong cpu_ns[N_PASSES];
+} PassStats;
+
+// Per-run options shared by single-file and batch mode
+typedef struct {
+    int verbose;            // Print the interactive progress log
+    int parse_threads;      // > 1 parses large inputs as line-aligned chunks in parallel
+    int cfg_threads;        // Threads measuring the functions of the CFG
+    ScannerKind scanner;    // flex DFA or the SIMD scanner
+    const RuleSet *rules;   // Behaviour rules, compiled once at startup
+    ApiCache *api_cache;    // What the rules make of each API name, shared
+    unsigned passes;        // PASS_BIT()s of the passes to run
+    PassStats *pass_stats;  // Shared by the batch workers
+} AnalyzeOptions;
+
+// main.c
+void ensure_output_dir(const char *filepath);
+int analyze_file(const char *infile, const char *outfile, const AnalyzeOptions *opts,
+                 char *error, size_t error_len);
+int passes_from_list(const char *list, unsigned *passes);
+void print_pass_stats(FILE *f, const PassStats *stats);
+
+// batch.c
+int run_batch(const char *source, const char *out_dir, int num_workers,
+              const AnalyzeOptions *opts);
+
+// parallel_parse.c
+int parse_input(InputBuffer *in, CDContext *ctx, const AnalyzeOptions *opts);
+
+#endif // FRONTEND_H
@@ -0,0 +1,53 @@
+#!/usr/bin/env python3
+"""
+Embed a text file in C as a string constant.
+
+    gen_embed.py <name> <text-file> <output.c>
+
+The output defines
+
+    const char <name>[];
+
+holding the file's text with a terminating NUL, so the program can
+carry a default copy of a file it otherwise reads at run time.
+"""
+
+import sys
+
+
+def c_string(line):
+    out = []
+    for ch in line:
+        if ch in "\\\"":
+            out.append("\\" + ch)
+        elif ch == "\n":
+            out.append("\\n")
+        elif ch == "\t":
+            out.append("\\t")
+        elif " " <= ch <= "~":
+            out.append(ch)
+        else:
+            # Octal, since a hex escape would swallow a following digit
+            out.append("\\%03o" % ord(ch))
+    return '"' + "".join(out) + '"'
+
+
+def main():
+    args = sys.argv[1:]
+    if len(args) != 3:
+        sys.exit("usage: " + __doc__.strip().splitlines()[2].strip())
+
+    name, text_path, out_path = args
+    with open(text_path, encoding="latin-1", newline="") as f:
+        text = f.read().replace("\r\n", "\n")
+
+    with open(out_path, "w") as out:
+        out.write("// Generated by gen_embed.py; do not edit.\n\n")
+        out.write(f"const char {name}[] =\n")
+        for line in text.splitlines(keepends=True) or [""]:
+            out.write(f"    {c_string(line)}\n")
+        out.write("    ;\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""
+Generate a case-insensitive perfect-hash lookup table in C.
+
+    gen_phash.py [--macro NAME] <name> <words-file> <output.c>
+
+Each non-blank, non-'#' line of the words file is `WORD [VALUE]`, where
+VALUE is a C expression (defaults to the word's index). With --macro,
+the words are instead the first arguments of the NAME(word, ...) entries
+of an X-macro table such as mnemonics.def, valued by their position, so
+the lookup returns the matching enum constant. The output defines
+
+    int <name>_lookup(const char *s, size_t len);
+
+returning the word's VALUE, or -1 if s[0..len) is not in the set.
+
+The table uses hash-and-displace: one 64-bit FNV-1a pass over the key
+picks a bucket, the bucket's displacement picks the slot, and a single
+length check plus compare confirms the hit. Keys are folded to upper
+case while hashing, so "eax" and "EAX" land in the same slot.
+"""
+
+import re
+import sys
+
+FNV_OFFSET = 0xCBF29CE484222325
+FNV_PRIME = 0x100000001B3
+MASK64 = (1 << 64) - 1
+
+
+def fnv1a(word, seed):
+    h = FNV_OFFSET ^ seed
+    for c in word.encode():
+        h ^= c
+        h = (h * FNV_PRIME) & MASK64
+    return h
+
+
+def read_macro_words(path, macro):
+    entry = re.compile(r"^\s*" + re.escape(macro) + r"\(\s*(\w+)\s*,")
+    words = []
+    for line in open(path):
+        m = entry.match(line)
+        if m:
+            words.append((m.group(1).upper(), str(len(words))))
+    return words
+
+
+def check_unique(path, words):
+    seen = set()
+    for word, _ in words:
+        if word in seen:
+            sys.exit(f"{path}: duplicate word {word}")
+        seen.add(word)
+
+
+def read_words(path):
+    words = []
+    for line in open(path):
+        line = line.split('#', 1)[0].strip()
+        if not line:
+            continue
+        parts = line.split(None, 1)
+        word = parts[0].upper()
+        value = parts[1] if len(parts) > 1 else str(len(words))
+        words.append((word, value))
+    return words
+
+
+def build(words):
+    """Return (seed, num_buckets, displacements, slots) for a perfect hash."""
+    n = len(words)
+    size = 1
+    while size < n:
+        size *= 2
+    num_buckets = max(1, n // 3)
+
+    # Seeds only matter if a bucket cannot be placed, which is rare
+    for seed in range(1000):
+        buckets = [[] for _ in range(num_buckets)]
+        for i, (word, _) in enumerate(words):
+            h = fnv1a(word, seed)
+            buckets[(h >> 32) % num_buckets].append((i, h))
+
+        slots = [None] * size
+        disp = [0] * num_buckets
+        ok = True
+
+        # Largest buckets first, while the table is still empty
+        for b in sorted(range(num_buckets), key=lambda b: -len(buckets[b])):
+            members = buckets[b]
+            if not members:
+                continue
+            for d in range(size):
+                placed = [((h & 0xFFFFFFFF) + d * ((h >> 32) | 1)) & (size - 1)
+                          for _, h in members]
+                if len(set(placed)) == len(placed) and all(slots[s] is None for s in placed):
+                    for (i, _), s in zip(members, placed):
+                        slots[s] = i
+                    disp[b] = d
+                    break
+            else:
+                ok = False
+                break
+
+        if ok:
+            return seed, num_buckets, disp, slots
+
+    sys.exit("could not build a perfect hash; add more buckets")
+
+
+def emit(name, words, seed, num_buckets, disp, slots, out):
+    size = len(slots)
+    min_len = min(len(w) for w, _ in words)
+    max_len = max(len(w) for w, _ in words)
+
+    out.write(f"// Generated by gen_phash.py; do not edit.\n\n")
+    out.write("#include <stddef.h>\n#include <stdint.h>\n\n")
+
+    out.write(f"static const uint32_t {name}_disp[{num_buckets}] = {{\n")
+    for i in range(0, num_buckets, 12):
+        out.write("    " + " ".join(f"{d}," for d in disp[i:i + 12]) + "\n")
+    out.write("};\n\n")
+
+    out.write(f"static const struct {{\n    const char *key;\n    unsigned char len;\n    int value;\n}} {name}_slots[{size}] = {{\n")
+    for i in slots:
+        if i is None:
+            out.write("    { NULL, 0, -1 },\n")
+        else:
+            word, value = words[i]
+            out.write(f"    {{ \"{word}\", {len(word)}, {value} }},\n")
+    out.write("};\n\n")
+
+    out.write(f"""int {name}_lookup(const char *s, size_t len) {{
+    if (len < {min_len} || len > {max_len}) {{
+        return -1;
+    }}
+
+    uint64_t h = 0x{FNV_OFFSET ^ seed:016X}ull;
+    for (size_t i = 0; i < len; i++) {{
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 'a' && c <= 'z') {{
+            c -= 'a' - 'A';
+        }}
+        h ^= c;
+        h *= 0x{FNV_PRIME:X}ull;
+    }}
+
+    uint32_t hi = (uint32_t)(h >> 32);
+    uint32_t d = {name}_disp[hi % {num_buckets}u];
+    uint32_t slot = ((uint32_t)h + d * (hi | 1u)) & {size - 1}u;
+
+    const char *key = {name}_slots[slot].key;
+    if ({name}_slots[slot].len != len) {{
+        return -1;
+    }}
+    for (size_t i = 0; i < len; i++) {{
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 'a' && c <= 'z') {{
+            c -= 'a' - 'A';
+        }}
+        if (c != (unsigned char)key[i]) {{
+            return -1;
+        }}
+    }}
+    return {name}_slots[slot].value;
+}}
+""")
+
+
+def main():
+    args = sys.argv[1:]
+    macro = None
+    if len(args) == 5 and args[0] == "--macro":
+        macro = args[1]
+        args = args[2:]
+    if len(args) != 3:
+        sys.exit("usage: " + __doc__.strip().splitlines()[2].strip())
+
+    name, words_path, out_path = args
+    words = read_macro_words(words_path, macro) if macro else read_words(words_path)
+    check_unique(words_path, words)
+    seed, num_buckets, disp, slots = build(words)
+    with open(out_path, "w") as out:
+        emit(name, words, seed, num_buckets, disp, slots, out)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+#include "image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t read_u32(const char *p) {
+    const uint8_t *b = (const uint8_t *)p;
+    return b[0] | b[1] << 8 | b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+// Sniff the magic numbers only; a listing never starts with them
+ImageFormat image_format(const char *data, size_t len) {
+    if (len >= 64 && data[0] == 'M' && data[1] == 'Z') {
+        uint32_t pe = read_u32(data + 0x3C);       // e_lfanew
+        if (pe <= len - 4 && memcmp(data + pe, "PE\0\0", 4) == 0) {
+            return IMAGE_PE;
+        }
+    }
+    // The identification bytes, up to and including EI_VERSION
+    if (len >= 16 && memcmp(data, "\x7F" "ELF", 4) == 0) {
+        return IMAGE_ELF;
+    }
+    return IMAGE_NONE;
+}
+
+int image_load(Image *img, const char *data, size_t len, char *error, size_t error_len) {
+    memset(img, 0, sizeof(Image));
+
+    switch (image_format(data, len)) {
+    case IMAGE_PE:
+        return pe_load(img, (const uint8_t *)data, len, error, error_len);
+    case IMAGE_ELF:
+        return elf_load(img, (const uint8_t *)data, len, error, error_len);
+    case IMAGE_NONE:
+        break;
+    }
+    snprintf(error, error_len, "not an executable image");
+    return -1;
+}
+
+void image_free(Image *img) {
+    free(img->sections);
+    free(img->imports);
+    free(img->stubs);
+    free(img->symbols);
+    free(img->functions);
+    img->sections = NULL;
+    img->sections_len = 0;
+    img->imports = NULL;
+    img->imports_len = 0;
+    img->stubs = NULL;
+    img->stubs_len = 0;
+    img->symbols = NULL;
+    img->symbols_len = 0;
+    img->functions = NULL;
+    img->functions_len = 0;
+}
+
+const ImageImport *image_find_import(const Image *img, uint64_t addr) {
+    size_t lo = 0, hi = img->imports_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (img->imports[mid].slot < addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < img->imports_len && img->imports[lo].slot == addr ? &img->imports[lo] : NULL;
+}
+
+const ImageStub *image_find_stub(const Image *img, uint64_t addr) {
+    // Last stub starting at or before addr
+    size_t lo = 0, hi = img->stubs_len;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (img->stubs[mid].addr <= addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return NULL;
+    }
+    const ImageStub *stub = &img->stubs[lo - 1];
+    return addr - stub->addr < stub->size ? stub : NULL;
+}
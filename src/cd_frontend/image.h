@@ -0,0 +1,83 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    IMAGE_NONE,         // Not a recognised executable: treat as a listing
+    IMAGE_PE,
+    IMAGE_ELF,
+} ImageFormat;
+
+// One section of a loaded image. data points into the caller's mapping.
+typedef struct {
+    char name[9];
+    uint64_t vaddr;
+    const uint8_t *data;
+    size_t size;        // Bytes of data present in the file
+    int exec;           // Holds code, i.e. objdump -d disassembles it
+} ImageSection;
+
+// A function the image imports, by name or by ordinal. The loader
+// writes its address into the IAT (or GOT) slot, so code calls it as
+// "call [slot]". Strings point into the mapping and are not NUL-terminated.
+typedef struct {
+    uint64_t slot;      // Virtual address of the IAT or GOT entry
+    const char *dll;    // NULL where the format does not bind one (ELF)
+    const char *name;   // NULL for an import by ordinal
+    uint32_t dll_len;
+    uint32_t name_len;
+    uint16_t ordinal;
+} ImageImport;
+
+// An ELF PLT entry: code at [addr, addr + size) that jumps to imp
+typedef struct {
+    uint64_t addr;
+    uint32_t size;
+    const ImageImport *imp;
+} ImageStub;
+
+// An executable viewed in place: nothing is copied out of the mapping,
+// so the Image must not outlive the InputBuffer it was loaded from
+typedef struct {
+    ImageFormat format;
+    int bits;           // 32 or 64
+    uint64_t image_base;
+    uint64_t entry;     // Virtual address of the entry point
+    ImageSection *sections;
+    size_t sections_len;
+    ImageImport *imports;   // Sorted by slot
+    size_t imports_len;
+    ImageStub *stubs;       // Sorted by address
+    size_t stubs_len;
+    // Sorted, distinct addresses where objdump restarts decoding
+    // inside a code section: its symbols, and PLT entries
+    uint64_t *symbols;
+    size_t symbols_len;
+    // Function entry points the file records: the PE exception directory
+    // or ELF function symbols. Unsorted, and empty when stripped.
+    uint64_t *functions;
+    size_t functions_len;
+} Image;
+
+ImageFormat image_format(const char *data, size_t len);
+
+// Load the image in data[0, len). Returns 0 on success, or -1 with the
+// reason written to error when the file is malformed or not x86.
+int image_load(Image *img, const char *data, size_t len, char *error, size_t error_len);
+void image_free(Image *img);
+
+// The import whose IAT slot is at addr, or NULL
+const ImageImport *image_find_import(const Image *img, uint64_t addr);
+
+// The PLT entry containing addr, or NULL
+const ImageStub *image_find_stub(const Image *img, uint64_t addr);
+
+// pe_loader.c
+int pe_load(Image *img, const uint8_t *data, size_t len, char *error, size_t error_len);
+
+// elf_loader.c
+int elf_load(Image *img, const uint8_t *data, size_t len, char *error, size_t error_len);
+
+#endif // IMAGE_H
@@ -0,0 +1,90 @@
+#include "input_buffer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define EOB_PAD 2           // Two NUL bytes terminate a flex scan buffer
+
+// Map a regular file copy-on-write, followed by EOB_PAD zero bytes.
+// An anonymous reservation one padding longer than the file is made
+// first and the file is mapped over its start, so the padding is always
+// backed by zero pages even when the file ends exactly on a page boundary.
+// flex temporarily NUL-terminates each token in place, hence PROT_WRITE.
+static int map_file(InputBuffer *in, int fd, size_t len) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t map_len = (len + EOB_PAD + page - 1) & ~(page - 1);
+
+    char *base = mmap(NULL, map_len, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return -1;
+    }
+
+    if (mmap(base, len, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        int saved = errno;
+        munmap(base, map_len);
+        errno = saved;
+        return -1;
+    }
+
+    madvise(base, map_len, MADV_SEQUENTIAL);
+
+    in->data = base;
+    in->len = len;
+    in->map_len = map_len;
+    return 0;
+}
+
+int input_open(InputBuffer *in, const char *path) {
+    in->data = NULL;
+    in->len = 0;
+    in->map_len = 0;
+    in->stream = NULL;
+
+    if (strcmp(path, "-") == 0) {
+        in->stream = stdin;
+        return 0;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        map_file(in, fd, (size_t)st.st_size) == 0) {
+        close(fd);
+        return 0;
+    }
+
+    // Empty files, pipes and devices
+    in->stream = fdopen(fd, "r");
+    if (!in->stream) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return 0;
+}
+
+void input_close(InputBuffer *in) {
+    if (in->stream) {
+        if (in->stream != stdin) {
+            fclose(in->stream);
+        }
+    } else if (in->map_len) {
+        munmap(in->data, in->map_len);
+    }
+    in->data = NULL;
+    in->len = 0;
+    in->map_len = 0;
+    in->stream = NULL;
+}
@@ -0,0 +1,26 @@
+#ifndef INPUT_BUFFER_H
+#define INPUT_BUFFER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Input handed to the scanner: either a whole mapped file or a stream.
+// For a mapping, data[len] and data[len + 1] are always NUL, which is the
+// end-of-buffer marker flex's yy_scan_buffer expects, so the scanner can
+// run directly on the mapping instead of copying it into its own buffer.
+// Pipes, devices and "-" (stdin) are left as a stream and scanned through
+// a fixed-size window, so e.g. `objdump -d ... | meef_parser -` runs in
+// bounded memory however long the listing is.
+typedef struct {
+    char *data;         // NULL for a stream
+    size_t len;
+    size_t map_len;     // Length of the mapping
+    FILE *stream;       // Non-NULL when the input must be read sequentially
+} InputBuffer;
+
+// Map a regular file, or open anything else as a stream.
+// Returns 0 on success, -1 with errno set on failure.
+int input_open(InputBuffer *in, const char *path);
+void input_close(InputBuffer *in);
+
+#endif // INPUT_BUFFER_H
@@ -1,15 +1,71 @@
 #include <stdio.h>
 #include "cd_context.h"
 
-void write_ir_json(CDContext *ctx, const char *outpath) {
+// Length of the well-formed UTF-8 sequence at s, or 0 if there is none
+static size_t utf8_sequence(const unsigned char *s) {
+    size_t len = s[0] >= 0xF0 ? 4 : s[0] >= 0xE0 ? 3 : s[0] >= 0xC2 ? 2 : 0;
+    if (s[0] > 0xF4) {
+        return 0;
+    }
+    for (size_t i = 1; i < len; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+    }
+    // Overlong forms, UTF-16 surrogates and code points past U+10FFFF
+    if ((s[0] == 0xE0 && s[1] < 0xA0) || (s[0] == 0xED && s[1] >= 0xA0) ||
+        (s[0] == 0xF0 && s[1] < 0x90) || (s[0] == 0xF4 && s[1] >= 0x90)) {
+        return 0;
+    }
+    return len;
+}
+
+// Write str as a JSON string. File names and the names taken from a
+// binary's import tables or from a listing can hold any byte, so quotes,
+// backslashes and control characters are escaped, and bytes that are not
+// UTF-8 become U+FFFD.
+static void write_json_string(FILE *f, const char *str) {
+    const unsigned char *s = (const unsigned char *)str;
+    fputc('"', f);
+    while (*s) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', f);
+            fputc(*s++, f);
+        } else if (*s < 0x20) {
+            fprintf(f, "\\u%04x", *s++);
+        } else if (*s < 0x80) {
+            fputc(*s++, f);
+        } else {
+            size_t len = utf8_sequence(s);
+            if (len == 0) {
+                fputs("\\ufffd", f);
+                s++;
+            } else {
+                fwrite(s, 1, len, f);
+                s += len;
+            }
+        }
+    }
+    fputc('"', f);
+}
+
+static void write_distribution(FILE *f, const char *name, const Distribution *d,
+                               const char *sep) {
+    fprintf(f, "    \"%s\": {\"max\": %.4f, \"p50\": %.4f, \"p95\": %.4f}%s\n",
+            name, d->max, d->p50, d->p95, sep);
+}
+
+int write_ir_json(CDContext *ctx, const char *outpath) {
     FILE *f = fopen(outpath, "w");
     if (!f) {
         perror("fopen");
-        return;
+        return -1;
     }
     
     fprintf(f, "{\n");
-    fprintf(f, "  \"filename\": \"%s\",\n", ctx->filename);
+    fprintf(f, "  \"filename\": ");
+    write_json_string(f, ctx->filename);
+    fprintf(f, ",\n");
     
     // Semantic analysis results
     fprintf(f, "  \"behavior\": {\n");
@@ -27,14 +83,20 @@ void write_ir_json(CDContext *ctx, const char *outpath) {
     fprintf(f, "    \"num_blocks\": %d,\n", ctx->cfg_num_blocks);
     fprintf(f, "    \"num_edges\": %d,\n", ctx->cfg_num_edges);
     fprintf(f, "    \"branch_density\": %.4f,\n", ctx->cfg_branch_density);
-    fprintf(f, "    \"cyclomatic_complexity\": %.4f\n", ctx->cfg_cyclomatic_complexity);
+    fprintf(f, "    \"cyclomatic_complexity\": %.4f,\n", ctx->cfg_cyclomatic_complexity);
+    fprintf(f, "    \"num_functions\": %d,\n", ctx->cfg_num_functions);
+    write_distribution(f, "function_blocks", &ctx->cfg_func_blocks, ",");
+    write_distribution(f, "function_complexity", &ctx->cfg_func_complexity, ",");
+    fprintf(f, "    \"num_loops\": %d,\n", ctx->cfg_num_loops);
+    fprintf(f, "    \"max_loop_depth\": %d\n", ctx->cfg_max_loop_depth);
     fprintf(f, "  },\n");
     
     // API calls
     fprintf(f, "  \"apis\": [\n");
     for (size_t i = 0; i < ctx->apis_len; i++) {
-        fprintf(f, "    {\"name\": \"%s\", \"count\": %d}%s\n",
-                ctx->apis[i].key,
+        fprintf(f, "    {\"name\": ");
+        write_json_string(f, ctx->apis[i].key);
+        fprintf(f, ", \"count\": %d}%s\n",
                 ctx->apis[i].count,
                 (i < ctx->apis_len - 1) ? "," : "");
     }
@@ -43,13 +105,28 @@ void write_ir_json(CDContext *ctx, const char *outpath) {
     // Opcodes
     fprintf(f, "  \"opcodes\": [\n");
     for (size_t i = 0; i < ctx->opcodes_len; i++) {
-        fprintf(f, "    {\"name\": \"%s\", \"count\": %d}%s\n",
-                ctx->opcodes[i].key,
-                ctx->opcodes[i].count,
+        Mnemonic op = ctx->opcode_order[i];
+        fprintf(f, "    {\"name\": \"%s\", \"count\": %u}%s\n",
+                mnemonic_names[op],
+                ctx->opcode_counts[op],
                 (i < ctx->opcodes_len - 1) ? "," : "");
     }
-    fprintf(f, "  ]\n");
+    fprintf(f, "  ],\n");
+    
+    // Opcodes inside loops, in the same order
+    fprintf(f, "  \"loop_opcodes\": [");
+    const char *sep = "\n";
+    for (size_t i = 0; i < ctx->opcodes_len; i++) {
+        Mnemonic op = ctx->opcode_order[i];
+        if (ctx->loop_opcode_counts[op] == 0) {
+            continue;
+        }
+        fprintf(f, "%s    {\"name\": \"%s\", \"count\": %u}",
+                sep, mnemonic_names[op], ctx->loop_opcode_counts[op]);
+        sep = ",\n";
+    }
+    fprintf(f, "%s]\n", sep[0] == ',' ? "\n  " : "");
     
     fprintf(f, "}\n");
-    fclose(f);
+    return fclose(f) == 0 ? 0 : -1;
 }
@@ -0,0 +1,220 @@
+#include "loops.h"
+#include <stdlib.h>
+
+#define UNDEFINED UINT32_MAX
+
+// Predecessor lists, in the same CSR form as the successors
+static void build_preds(const FuncGraph *g, uint32_t *pred_start, uint32_t *preds) {
+    size_t n = g->nodes;
+    for (size_t v = 0; v <= n; v++) {
+        pred_start[v] = 0;
+    }
+    for (uint32_t e = 0; e < g->succ_start[n]; e++) {
+        pred_start[g->succ[e] + 1]++;
+    }
+    for (size_t v = 0; v < n; v++) {
+        pred_start[v + 1] += pred_start[v];
+    }
+
+    // pred_start[v] runs ahead while v's list fills, then is moved back
+    for (size_t u = 0; u < n; u++) {
+        for (uint32_t e = g->succ_start[u]; e < g->succ_start[u + 1]; e++) {
+            preds[pred_start[g->succ[e]]++] = (uint32_t)u;
+        }
+    }
+    for (size_t v = n; v > 0; v--) {
+        pred_start[v] = pred_start[v - 1];
+    }
+    pred_start[0] = 0;
+}
+
+// Depth-first postorder from the entry: po[v] is v's number and order[i]
+// the node numbered i, so the entry is last
+static void number_postorder(const FuncGraph *g, uint32_t *po, uint32_t *order) {
+    size_t n = g->nodes;
+    uint32_t *stack = malloc(n * sizeof(uint32_t));
+    uint32_t *cursor = malloc(n * sizeof(uint32_t));
+    for (size_t v = 0; v < n; v++) {
+        po[v] = UNDEFINED;
+        cursor[v] = UNDEFINED;
+    }
+
+    size_t top = 0, next = 0;
+    stack[top++] = 0;
+    cursor[0] = g->succ_start[0];
+    while (top > 0) {
+        uint32_t v = stack[top - 1];
+        if (cursor[v] < g->succ_start[v + 1]) {
+            uint32_t s = g->succ[cursor[v]++];
+            if (cursor[s] == UNDEFINED) {
+                cursor[s] = g->succ_start[s];
+                stack[top++] = s;
+            }
+            continue;
+        }
+        top--;
+        po[v] = (uint32_t)next;
+        order[next++] = v;
+    }
+    free(stack);
+    free(cursor);
+}
+
+static uint32_t intersect(const uint32_t *idom, uint32_t a, uint32_t b) {
+    while (a != b) {
+        while (a < b) {
+            a = idom[a];
+        }
+        while (b < a) {
+            b = idom[b];
+        }
+    }
+    return a;
+}
+
+// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm":
+// refine each node's immediate dominator over reverse postorder until
+// nothing changes, meeting predecessors by walking up the tree in
+// postorder numbers. Reducible code settles in two passes. Nodes are
+// indexed by postorder number, so the entry is n - 1.
+static void find_dominators(size_t n, const uint32_t *pred_start, const uint32_t *preds,
+                            const uint32_t *po, const uint32_t *order, uint32_t *idom) {
+    for (size_t i = 0; i < n; i++) {
+        idom[i] = UNDEFINED;
+    }
+    idom[n - 1] = (uint32_t)(n - 1);
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (size_t i = n - 1; i-- > 0;) {
+            uint32_t v = order[i], best = UNDEFINED;
+            for (uint32_t e = pred_start[v]; e < pred_start[v + 1]; e++) {
+                uint32_t p = po[preds[e]];
+                if (idom[p] != UNDEFINED) {
+                    best = best == UNDEFINED ? p : intersect(idom, p, best);
+                }
+            }
+            if (idom[i] != best) {
+                idom[i] = best;
+                changed = 1;
+            }
+        }
+    }
+}
+
+// Enter and leave times of a depth-first walk of the dominator tree:
+// a dominates b exactly when a's interval holds b's
+static void number_tree(size_t n, const uint32_t *idom, uint32_t *tin, uint32_t *tout) {
+    uint32_t *child_start = calloc(n + 1, sizeof(uint32_t));
+    uint32_t *children = malloc(n * sizeof(uint32_t));
+    uint32_t *stack = malloc(n * sizeof(uint32_t));
+    uint32_t *cursor = malloc(n * sizeof(uint32_t));
+
+    for (size_t i = 0; i + 1 < n; i++) {
+        child_start[idom[i] + 1]++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        child_start[i + 1] += child_start[i];
+        cursor[i] = child_start[i];
+    }
+    for (size_t i = 0; i + 1 < n; i++) {
+        children[cursor[idom[i]]++] = (uint32_t)i;
+    }
+    for (size_t i = 0; i < n; i++) {
+        cursor[i] = child_start[i];
+    }
+
+    uint32_t clock = 0;
+    size_t top = 0;
+    stack[top++] = (uint32_t)(n - 1);
+    tin[n - 1] = clock++;
+    while (top > 0) {
+        uint32_t v = stack[top - 1];
+        if (cursor[v] < child_start[v + 1]) {
+            uint32_t c = children[cursor[v]++];
+            tin[c] = clock++;
+            stack[top++] = c;
+        } else {
+            tout[v] = clock++;
+            top--;
+        }
+    }
+
+    free(child_start);
+    free(children);
+    free(stack);
+    free(cursor);
+}
+
+size_t find_loops(const FuncGraph *g, uint32_t *depth) {
+    size_t n = g->nodes;
+    uint32_t *pred_start = malloc((n + 1) * sizeof(uint32_t));
+    uint32_t *preds = malloc((g->succ_start[n] + 1) * sizeof(uint32_t));
+    uint32_t *po = malloc(n * sizeof(uint32_t));
+    uint32_t *order = malloc(n * sizeof(uint32_t));
+    uint32_t *idom = malloc(n * sizeof(uint32_t));
+    uint32_t *tin = malloc(n * sizeof(uint32_t));
+    uint32_t *tout = malloc(n * sizeof(uint32_t));
+
+    build_preds(g, pred_start, preds);
+    number_postorder(g, po, order);
+    find_dominators(n, pred_start, preds, po, order, idom);
+    number_tree(n, idom, tin, tout);
+
+    // stamp[v] == h + 1 once v is known to be in h's loop
+    uint32_t *stamp = calloc(n, sizeof(uint32_t));
+    uint32_t *work = malloc(n * sizeof(uint32_t));
+    size_t loops = 0;
+    for (size_t v = 0; v < n; v++) {
+        depth[v] = 0;
+    }
+
+    for (size_t h = 0; h < n; h++) {
+        uint32_t hp = po[h], mark = (uint32_t)h + 1;
+        size_t top = 0;
+        int header = 0;
+
+        // Back edges into h come from the nodes it dominates
+        for (uint32_t e = pred_start[h]; e < pred_start[h + 1]; e++) {
+            uint32_t t = preds[e], tp = po[t];
+            if (tin[hp] > tin[tp] || tout[tp] > tout[hp]) {
+                continue;
+            }
+            header = 1;
+            if (t != h && stamp[t] != mark) {
+                stamp[t] = mark;
+                work[top++] = t;
+            }
+        }
+        if (!header) {
+            continue;
+        }
+
+        loops++;
+        stamp[h] = mark;
+        depth[h]++;
+        while (top > 0) {
+            uint32_t v = work[--top];
+            depth[v]++;
+            for (uint32_t e = pred_start[v]; e < pred_start[v + 1]; e++) {
+                uint32_t p = preds[e];
+                if (stamp[p] != mark) {
+                    stamp[p] = mark;
+                    work[top++] = p;
+                }
+            }
+        }
+    }
+
+    free(pred_start);
+    free(preds);
+    free(po);
+    free(order);
+    free(idom);
+    free(tin);
+    free(tout);
+    free(stamp);
+    free(work);
+    return loops;
+}
@@ -0,0 +1,23 @@
+#ifndef LOOPS_H
+#define LOOPS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One function's part of the CFG, renumbered locally: node 0 is the
+// entry, every node is reachable from it, and the successors of node v
+// are succ[succ_start[v], succ_start[v + 1]).
+typedef struct {
+    size_t nodes;
+    const uint32_t *succ_start;     // nodes + 1 entries
+    const uint32_t *succ;
+} FuncGraph;
+
+// Natural loops of g, found from its dominator tree: one loop per
+// header, made of the header and every node that reaches one of its
+// back edges without passing through it. depth[v] (nodes entries,
+// filled by the caller's buffer) receives the number of loops holding v.
+// Returns the number of loops.
+size_t find_loops(const FuncGraph *g, uint32_t *depth);
+
+#endif // LOOPS_H
@@ -1,112 +1,479 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <sys/stat.h>
 
-#include "parser.tab.h"
 #include "cd_context.h"
+#include "input_buffer.h"
+#include "frontend.h"
+#include "image.h"
+#include "disasm.h"
+#include "simd_scanner.h"
+#include "thread_pool.h"
 
-extern int yyparse(void);
-extern FILE *yyin;
-CDContext global_ctx;
+// Upper limit for -j, --parse-threads and --cfg-threads
+#define MAX_THREADS 1024
 
-extern void semantic_analyze(CDContext *ctx);
-extern void build_cfg(CDContext *ctx);
-extern void write_ir_json(CDContext *ctx, const char *outpath);
+extern void categorize_apis(CDContext *ctx, const RuleSet *rules, ApiCache *cache);
+extern void semantic_analyze(CDContext *ctx, const RuleSet *rules);
+extern int write_ir_json(CDContext *ctx, const char *outpath);
 
-// Ensure output directory exists
+// Ensure output directory exists, creating any missing parents too
 void ensure_output_dir(const char *filepath) {
     char *path_copy = strdup(filepath);
     char *last_slash = strrchr(path_copy, '/');
     
-    if (last_slash) {
+    if (last_slash && last_slash != path_copy) {
         *last_slash = '\0';
         
-        // Create directory (ignoring errors if it exists)
-        #ifdef _WIN32
-        mkdir(path_copy);
-        #else
-        mkdir(path_copy, 0755);
-        #endif
+        // Create each level in turn (ignoring errors if it exists)
+        for (char *p = path_copy + 1; ; p++) {
+            if (*p != '/' && *p != '\0') {
+                continue;
+            }
+            char c = *p;
+            *p = '\0';
+            #ifdef _WIN32
+            mkdir(path_copy);
+            #else
+            mkdir(path_copy, 0755);
+            #endif
+            *p = c;
+            if (c == '\0') {
+                break;
+            }
+        }
     }
     
     free(path_copy);
 }
 
-int main(int argc, char **argv) {
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <asm_file> [output.json]\n", argv[0]);
-        fprintf(stderr, "Example: %s ../../samples/dummy/fake.asm output/fake_ir.json\n", argv[0]);
-        return 1;
+static void print_summary(const CDContext *ctx) {
+    printf("\n╔══════════════════════════════════════════════════════════╗\n");
+    printf("║                    Analysis Summary                      ║\n");
+    printf("╠══════════════════════════════════════════════════════════╣\n");
+    printf("║ Network Operations    : %s\n", ctx->uses_network ? "YES" : "NO ");
+    printf("║ File Operations       : %s\n", ctx->uses_fileops ? "YES" : "NO ");
+    printf("║ Registry Operations   : %s\n", ctx->uses_registry ? "YES" : "NO ");
+    printf("║ Memory Operations     : %s\n", ctx->uses_memory ? "YES" : "NO ");
+    printf("║ Code Injection        : %s\n", ctx->uses_injection ? "YES" : "NO ");
+    printf("║ Cryptography          : %s\n", ctx->uses_crypto ? "YES" : "NO ");
+    printf("║ Persistence           : %s\n", ctx->uses_persist ? "YES" : "NO ");
+    printf("╠══════════════════════════════════════════════════════════╣\n");
+    printf("║ CFG Complexity        : %.2f\n", ctx->cfg_cyclomatic_complexity);
+    printf("║ Branch Density        : %.4f\n", ctx->cfg_branch_density);
+    printf("╚══════════════════════════════════════════════════════════╝\n\n");
+}
+
+// One file on its way through the passes
+typedef struct {
+    const AnalyzeOptions *opts;
+    const char *outfile;
+    InputBuffer input;
+    Image image;
+    int native;         // Disassembled from an executable, not parsed
+    CDContext ctx;
+} Analysis;
+
+// Release the input and the loaded image. Safe to call again once done.
+static void release_input(Analysis *a) {
+    if (a->native) {
+        image_free(&a->image);
+    }
+    input_close(&a->input);
+}
+
+static const char *run_parse(Analysis *a) {
+    int parse_result = 0;
+    if (a->native) {
+        disasm_image(&a->ctx, &a->image);
+    } else {
+        parse_result = parse_input(&a->input, &a->ctx, a->opts);
+    }
+    
+    // Tokens are interned and the image is released, so nothing refers
+    // to the input any more
+    release_input(a);
+    return parse_result != 0 ? "parsing failed" : NULL;
+}
+
+static const char *run_apis(Analysis *a) {
+    categorize_apis(&a->ctx, a->opts->rules, a->opts->api_cache);
+    return NULL;
+}
+
+static const char *run_cfg(Analysis *a) {
+    build_cfg(&a->ctx, a->opts->cfg_threads);
+    return NULL;
+}
+
+static const char *run_semantic(Analysis *a) {
+    semantic_analyze(&a->ctx, a->opts->rules);
+    return NULL;
+}
+
+static const char *run_ir(Analysis *a) {
+    ensure_output_dir(a->outfile);
+    return write_ir_json(&a->ctx, a->outfile) != 0 ? "could not write IR" : NULL;
+}
+
+static void report_parse(const Analysis *a) {
+    printf("[✓] Parsing successful\n");
+    printf("[*] Opcodes found: %zu\n", a->ctx.opcodes_len);
+    printf("[*] API calls found: %zu\n", a->ctx.apis_len);
+}
+
+static void report_apis(const Analysis *a) {
+    printf("[✓] API names categorized: %d named\n", a->ctx.named_apis);
+}
+
+static void report_cfg(const Analysis *a) {
+    printf("[✓] CFG built: %d blocks, %d edges, %d functions\n",
+           a->ctx.cfg_num_blocks,
+           a->ctx.cfg_num_edges,
+           a->ctx.cfg_num_functions);
+}
+
+static void report_semantic(const Analysis *a) {
+    (void)a;
+    printf("[✓] Semantic analysis complete\n");
+}
+
+static void report_ir(const Analysis *a) {
+    printf("[✓] IR written to: %s\n", a->outfile);
+}
+
+// A stage of the front-end. A pass pulls in the passes it needs when
+// selected, and only waits for the ones it merely runs after: without
+// them it reads their results as zero. run returns NULL, or the reason
+// it failed.
+typedef struct {
+    const char *name;
+    unsigned needs;                     // PASS_BIT()s run along with it
+    unsigned after;                     // PASS_BIT()s it waits for if selected
+    const char *title;                  // Progress message, NULL for none
+    const char *(*run)(Analysis *a);
+    void (*report)(const Analysis *a);  // Progress summary once it has run
+} Pass;
+
+// The heuristics read the CFG metrics, so semantic needs cfg. API
+// categorization and the CFG touch disjoint parts of the context and
+// run side by side. The IR writes whatever the selected passes produced,
+// so --passes=parse,ir is a quick opcode histogram.
+static const Pass passes[N_PASSES] = {
+    [PASS_PARSE] = { "parse", 0, 0, NULL, run_parse, report_parse },
+    [PASS_APIS] = { "apis", PASS_BIT(PASS_PARSE), 0, "Categorizing API names",
+                    run_apis, report_apis },
+    [PASS_CFG] = { "cfg", PASS_BIT(PASS_PARSE), 0, "Building Control Flow Graph",
+                   run_cfg, report_cfg },
+    [PASS_SEMANTIC] = { "semantic", PASS_BIT(PASS_APIS) | PASS_BIT(PASS_CFG), 0,
+                        "Running semantic analysis", run_semantic, report_semantic },
+    [PASS_IR] = { "ir", PASS_BIT(PASS_PARSE),
+                  PASS_BIT(PASS_APIS) | PASS_BIT(PASS_CFG) | PASS_BIT(PASS_SEMANTIC),
+                  "Generating Intermediate Representation", run_ir, report_ir },
+};
+
+// Parse a comma-separated list of pass names into the PASS_BIT()s to
+// run, adding the passes they need. Returns -1 for an unknown name or
+// an empty list.
+int passes_from_list(const char *list, unsigned *selected) {
+    unsigned mask = 0;
+    while (*list) {
+        size_t len = strcspn(list, ",");
+        int p = 0;
+        while (p < N_PASSES && !(strlen(passes[p].name) == len &&
+                                 strncmp(passes[p].name, list, len) == 0)) {
+            p++;
+        }
+        if (p == N_PASSES) {
+            return -1;
+        }
+        mask |= PASS_BIT(p);
+        list += len + (list[len] == ',');
+    }
+    if (mask == 0) {
+        return -1;
+    }
+    
+    // Needs point to earlier passes, so one backward sweep closes them
+    for (int p = N_PASSES - 1; p >= 0; p--) {
+        if (mask & PASS_BIT(p)) {
+            mask |= passes[p].needs;
+        }
+    }
+    *selected = mask;
+    return 0;
+}
+
+void print_pass_stats(FILE *f, const PassStats *stats) {
+    fprintf(f, "[*] Pass times\n");
+    fprintf(f, "    %-9s %8s %12s %12s\n", "pass", "runs", "wall_ms", "cpu_ms");
+    for (int p = 0; p < N_PASSES; p++) {
+        unsigned long long runs = atomic_load(&stats->runs[p]);
+        if (runs == 0) {
+            continue;
+        }
+        fprintf(f, "    %-9s %8llu %12.1f %12.1f\n", passes[p].name, runs,
+                atomic_load(&stats->wall_ns[p]) / 1e6, atomic_load(&stats->cpu_ns[p]) / 1e6);
+    }
+}
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Passes that became ready together
+typedef struct {
+    Analysis *a;
+    int pass[N_PASSES];
+    const char *failure[N_PASSES];
+} Wave;
+
+static void run_wave_pass(size_t i, void *arg) {
+    Wave *wave = arg;
+    int p = wave->pass[i];
+    uint64_t wall = clock_ns(CLOCK_MONOTONIC);
+    uint64_t cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    
+    wave->failure[i] = passes[p].run(wave->a);
+    
+    PassStats *stats = wave->a->opts->pass_stats;
+    atomic_fetch_add(&stats->runs[p], 1);
+    atomic_fetch_add(&stats->wall_ns[p], clock_ns(CLOCK_MONOTONIC) - wall);
+    atomic_fetch_add(&stats->cpu_ns[p], clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu);
+}
+
+// Run the selected passes in waves: each wave is every selected pass
+// whose predecessors have all finished, run concurrently. Returns NULL,
+// or the reason the first failing pass gave, after which no further
+// wave starts.
+static const char *run_passes(Analysis *a) {
+    int verbose = a->opts->verbose;
+    unsigned selected = a->opts->passes, done = 0;
+    
+    while (done != selected) {
+        Wave wave = { .a = a };
+        size_t n = 0;
+        for (int p = 0; p < N_PASSES; p++) {
+            unsigned waits = (passes[p].needs | passes[p].after) & selected;
+            if ((selected & ~done & PASS_BIT(p)) && (waits & ~done) == 0) {
+                wave.pass[n++] = p;
+            }
+        }
+        
+        if (verbose && passes[wave.pass[0]].title) {
+            printf("\n");
+        }
+        for (size_t i = 0; verbose && i < n; i++) {
+            if (passes[wave.pass[i]].title) {
+                printf("[*] %s...\n", passes[wave.pass[i]].title);
+            }
+        }
+        
+        parallel_for(n, (int)n, run_wave_pass, &wave);
+        
+        for (size_t i = 0; i < n; i++) {
+            if (wave.failure[i]) {
+                return wave.failure[i];
+            }
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (verbose) {
+                passes[wave.pass[i]].report(a);
+            }
+            done |= PASS_BIT(wave.pass[i]);
+        }
     }
+    return NULL;
+}
+
+// Run the whole front-end on one file. All state lives in a local context
+// and scanner, so batch workers may call this concurrently.
+// opts->verbose prints the interactive progress log; batch mode runs quietly.
+// Returns 0 on success, otherwise 1 with the reason written to error.
+int analyze_file(const char *infile, const char *outfile, const AnalyzeOptions *opts,
+                 char *error, size_t error_len) {
+    int verbose = opts->verbose;
+    Analysis a = { .opts = opts, .outfile = outfile };
     
-    const char *infile = argv[1];
-    const char *outfile = (argc >= 3) ? argv[2] : "output/sample_ir.json";
+    // Map input file (pipes and "-" are streamed instead)
+    if (input_open(&a.input, infile) != 0) {
+        strerror_r(errno, error, error_len);
+        return 1;
+    }
     
-    // Open input file
-    yyin = fopen(infile, "r");
-    if (!yyin) {
-        perror("Error opening input file");
+    // Executables are disassembled in place rather than parsed as a listing
+    a.native = a.input.data && image_format(a.input.data, a.input.len) != IMAGE_NONE;
+    if (a.native && image_load(&a.image, a.input.data, a.input.len, error, error_len) != 0) {
+        input_close(&a.input);
         return 1;
     }
     
     // Initialize context
-    ctx_init(&global_ctx, infile);
-    
-    printf("╔══════════════════════════════════════════════════════════╗\n");
-    printf("║        MEEF Compiler Design Front-End (Phase B)         ║\n");
-    printf("╚══════════════════════════════════════════════════════════╝\n\n");
-    printf("[*] Starting lexical & syntax analysis on: %s\n", infile);
+    ctx_init(&a.ctx, infile);
     
-    // Parse the input
-    int parse_result = yyparse();
-    fclose(yyin);
+    if (verbose) {
+        printf("╔══════════════════════════════════════════════════════════╗\n");
+        printf("║        MEEF Compiler Design Front-End (Phase B)         ║\n");
+        printf("╚══════════════════════════════════════════════════════════╝\n\n");
+        if (a.native) {
+            printf("[*] Disassembling %d-bit %s image: %s\n", a.image.bits,
+                   a.image.format == IMAGE_ELF ? "ELF" : "PE", infile);
+        } else {
+            printf("[*] Starting lexical & syntax analysis on: %s\n", infile);
+            if (opts->scanner == SCANNER_SIMD) {
+                printf("[*] Scanner: SIMD (%s kernels)\n", simd_scanner_isa());
+            }
+        }
+    }
     
-    if (parse_result != 0) {
-        fprintf(stderr, "\n[✗] Parsing failed\n");
-        ctx_free(&global_ctx);
+    const char *failure = run_passes(&a);
+    release_input(&a);      // Already done if parse ran
+    if (failure) {
+        ctx_free(&a.ctx);
+        snprintf(error, error_len, "%s", failure);
         return 1;
     }
     
-    printf("[✓] Parsing successful\n");
-    printf("[*] Opcodes found: %zu\n", global_ctx.opcodes_len);
-    printf("[*] API calls found: %zu\n", global_ctx.apis_len);
+    if (verbose && (opts->passes & PASS_BIT(PASS_SEMANTIC))) {
+        print_summary(&a.ctx);
+    } else if (verbose) {
+        printf("\n");
+    }
     
-    // Semantic analysis
-    printf("\n[*] Running semantic analysis...\n");
-    semantic_analyze(&global_ctx);
-    printf("[✓] Semantic analysis complete\n");
+    ctx_free(&a.ctx);
+    return 0;
+}
+
+// Parse a thread or worker count in [min, MAX_THREADS]. Returns -1 for
+// anything that is not a whole decimal number in range.
+static int parse_count(const char *arg, int min, int *count) {
+    char *end;
+    errno = 0;
+    long value = strtol(arg, &end, 10);
+    if (errno != 0 || end == arg || *end != '\0' || value < min || value > MAX_THREADS) {
+        return -1;
+    }
+    *count = (int)value;
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [options] <asm_file|-> [output.json]\n", prog);
+    fprintf(stderr, "       %s [options] --batch <list_file|dir> [--out-dir <dir>] [-j N]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  -j N                Batch workers, 0 (the default) for one per CPU\n");
+    fprintf(stderr, "  --parse-threads N   Parse large inputs as N line-aligned chunks in parallel\n");
+    fprintf(stderr, "  --scanner=NAME      Tokenizer: flex (default) or simd\n");
+    fprintf(stderr, "  --cfg-threads N     Measure the functions of the CFG on N threads\n");
+    fprintf(stderr, "  --rules FILE        Behaviour rules to use instead of the built-in ones\n");
+    fprintf(stderr, "  --passes=LIST       Run only these of parse,apis,cfg,semantic,ir (and what\n");
+    fprintf(stderr, "                      they need), e.g. --passes=parse,ir for opcode counts\n");
+    fprintf(stderr, "Input may be a cleaned listing, raw `objdump -d -M intel` output or a PE\n");
+    fprintf(stderr, "or ELF executable, which is disassembled directly; '-' reads stdin.\n");
+    fprintf(stderr, "Example: %s ../../samples/dummy/fake.asm output/fake_ir.json\n", prog);
+    fprintf(stderr, "         %s sample.exe output/sample_ir.json\n", prog);
+}
+
+int main(int argc, char **argv) {
+    PassStats pass_stats = {0};
+    AnalyzeOptions opts = { .verbose = 1, .parse_threads = 1, .cfg_threads = 1,
+                            .scanner = SCANNER_FLEX, .passes = ALL_PASSES,
+                            .pass_stats = &pass_stats };
+    const char *batch_source = NULL;
+    const char *rules_path = NULL;
+    const char *out_dir = "output/ir_results";
+    int jobs = 0;   // 0 = one batch worker per online CPU
+    const char *positional[2];
+    int num_positional = 0;
     
-    // CFG building
-    printf("\n[*] Building Control Flow Graph...\n");
-    build_cfg(&global_ctx);
-    printf("[✓] CFG built: %d blocks, %d edges\n", 
-           global_ctx.cfg_num_blocks, 
-           global_ctx.cfg_num_edges);
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch_source = argv[++i];
+        } else if (strcmp(argv[i], "--out-dir") == 0 && i + 1 < argc) {
+            out_dir = argv[++i];
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            if (parse_count(argv[++i], 0, &jobs) != 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--parse-threads") == 0 && i + 1 < argc) {
+            if (parse_count(argv[++i], 1, &opts.parse_threads) != 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--cfg-threads") == 0 && i + 1 < argc) {
+            if (parse_count(argv[++i], 1, &opts.cfg_threads) != 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            rules_path = argv[++i];
+        } else if (strncmp(argv[i], "--passes=", 9) == 0) {
+            if (passes_from_list(argv[i] + 9, &opts.passes) != 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--scanner=", 10) == 0) {
+            if (scanner_kind_from_name(argv[i] + 10, &opts.scanner) != 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+            print_usage(argv[0]);   // "-" alone is stdin, anything else is unknown
+            return 1;
+        } else if (num_positional < 2) {
+            positional[num_positional++] = argv[i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
     
-    // Generate IR
-    printf("\n[*] Generating Intermediate Representation...\n");
-    ensure_output_dir(outfile);
-    write_ir_json(&global_ctx, outfile);
-    printf("[✓] IR written to: %s\n", outfile);
+    if (!batch_source && num_positional < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
     
-    // Summary
-    printf("\n╔══════════════════════════════════════════════════════════╗\n");
-    printf("║                    Analysis Summary                      ║\n");
-    printf("╠══════════════════════════════════════════════════════════╣\n");
-    printf("║ Network Operations    : %s\n", global_ctx.uses_network ? "YES" : "NO ");
-    printf("║ File Operations       : %s\n", global_ctx.uses_fileops ? "YES" : "NO ");
-    printf("║ Registry Operations   : %s\n", global_ctx.uses_registry ? "YES" : "NO ");
-    printf("║ Memory Operations     : %s\n", global_ctx.uses_memory ? "YES" : "NO ");
-    printf("║ Code Injection        : %s\n", global_ctx.uses_injection ? "YES" : "NO ");
-    printf("║ Cryptography          : %s\n", global_ctx.uses_crypto ? "YES" : "NO ");
-    printf("║ Persistence           : %s\n", global_ctx.uses_persist ? "YES" : "NO ");
-    printf("╠══════════════════════════════════════════════════════════╣\n");
-    printf("║ CFG Complexity        : %.2f\n", global_ctx.cfg_cyclomatic_complexity);
-    printf("║ Branch Density        : %.4f\n", global_ctx.cfg_branch_density);
-    printf("╚══════════════════════════════════════════════════════════╝\n\n");
+    // Rules are compiled once and shared read-only by every sample, as is
+    // the cache of what they make of each API name
+    RuleSet rules;
+    char error[256];
+    int status = rules_path ? rules_load(&rules, rules_path, error, sizeof(error))
+                            : rules_compile(&rules, default_rules, "behaviour.rules",
+                                            error, sizeof(error));
+    if (status != 0) {
+        fprintf(stderr, "[✗] %s\n", error);
+        return 1;
+    }
+    opts.rules = &rules;
+    opts.api_cache = api_cache_new();
+    
+    // Batch mode: one process for a whole list or directory of samples
+    if (batch_source) {
+        opts.verbose = 0;
+        status = run_batch(batch_source, out_dir, jobs, &opts);
+        api_cache_free(opts.api_cache);
+        rules_free(&rules);
+        return status;
+    }
+    
+    const char *infile = positional[0];
+    const char *outfile = (num_positional >= 2) ? positional[1] : "output/sample_ir.json";
+    
+    status = analyze_file(infile, outfile, &opts, error, sizeof(error));
+    api_cache_free(opts.api_cache);
+    rules_free(&rules);
+    if (status != 0) {
+        fprintf(stderr, "\n[✗] %s: %s\n", infile, error);
+        return 1;
+    }
     
-    ctx_free(&global_ctx);
-    printf("[✓] Analysis complete!\n");
+    print_pass_stats(stdout, &pass_stats);
+    printf("\n[✓] Analysis complete!\n");
     return 0;
 }
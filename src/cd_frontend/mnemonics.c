@@ -0,0 +1,13 @@
+#include "mnemonics.h"
+
+const char *const mnemonic_names[N_MNEMONICS] = {
+#define MNEMONIC(name, flags) #name,
+#include "mnemonics.def"
+#undef MNEMONIC
+};
+
+const unsigned char mnemonic_flags[N_MNEMONICS] = {
+#define MNEMONIC(name, flags) flags,
+#include "mnemonics.def"
+#undef MNEMONIC
+};
@@ -0,0 +1,28 @@
+#ifndef MNEMONICS_H
+#define MNEMONICS_H
+
+#include <stddef.h>
+
+// Mnemonic attribute flags
+#define MN_F_JUMP   0x01    // JMP, Jcc, JrCXZ and LOOPcc
+#define MN_F_COND   0x02    // Conditional jump
+#define MN_F_CALL   0x04
+#define MN_F_RET    0x08
+
+typedef enum {
+#define MNEMONIC(name, flags) MN_##name,
+#include "mnemonics.def"
+#undef MNEMONIC
+    N_MNEMONICS
+} Mnemonic;
+
+extern const char *const mnemonic_names[N_MNEMONICS];
+extern const unsigned char mnemonic_flags[N_MNEMONICS];
+
+// Perfect-hash lookups generated from mnemonics.def and prefixes.txt.
+// Case-insensitive; mnemonic_lookup returns a Mnemonic, both return -1
+// for words outside their table.
+int mnemonic_lookup(const char *s, size_t len);
+int prefix_lookup(const char *s, size_t len);
+
+#endif // MNEMONICS_H
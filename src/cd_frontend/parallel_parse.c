@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parser.tab.h"
+#include "frontend.h"
+#include "thread_pool.h"
+
+// Inputs are only split when every chunk gets at least this much text;
+// below that, thread start-up and merging cost more than they save
+#define MIN_CHUNK_BYTES (1u << 20)
+
+// One line-aligned slice of the input, parsed into its own context
+typedef struct {
+    const char *data;
+    size_t len;
+    ScannerKind kind;
+    CDContext ctx;
+    int result;
+} ParseChunk;
+
+static void parse_chunk(size_t i, void *arg) {
+    ParseChunk *chunk = &((ParseChunk *)arg)[i];
+
+    // A slice cannot be NUL-terminated in place without clobbering the
+    // start of the next chunk, so flex scans a private copy
+    Scanner *scanner = scanner_begin_bytes(chunk->kind, chunk->data, chunk->len, &chunk->ctx);
+    if (!scanner) {
+        chunk->result = 1;
+        return;
+    }
+    chunk->result = yyparse(scanner, &chunk->ctx);
+    scanner_end(scanner);
+}
+
+// Split [data, data + len) into at most n chunks ending just after a
+// newline (the grammar is line-oriented, so each chunk parses alone).
+// Returns the number of chunks produced.
+static int split_lines(const char *data, size_t len, ParseChunk *chunks, int n) {
+    int count = 0;
+    size_t start = 0;
+
+    for (int i = 1; i <= n && start < len; i++) {
+        size_t end = len;
+        if (i < n) {
+            size_t target = len / (size_t)n * (size_t)i;
+            if (target < start) {
+                target = start;
+            }
+            const char *nl = memchr(data + target, '\n', len - target);
+            end = nl ? (size_t)(nl - data) + 1 : len;
+        }
+        chunks[count].data = data + start;
+        chunks[count].len = end - start;
+        count++;
+        start = end;
+    }
+    return count;
+}
+
+// Parse a whole input into ctx with the scanner chosen in opts. With
+// opts->parse_threads > 1 and a large enough input, the text is cut at
+// line boundaries and the chunks are parsed concurrently into
+// thread-local contexts that are merged afterwards.
+// Returns 0 on success like yyparse.
+int parse_input(InputBuffer *in, CDContext *ctx, const AnalyzeOptions *opts) {
+    // Streams can only be read front to back
+    int n = in->stream ? 1 : opts->parse_threads;
+    if ((size_t)n > in->len / MIN_CHUNK_BYTES) {
+        n = (int)(in->len / MIN_CHUNK_BYTES);
+    }
+
+    if (n <= 1) {
+        Scanner *scanner = scanner_begin(opts->scanner, in, ctx);
+        if (!scanner) {
+            return 1;
+        }
+        int result = yyparse(scanner, ctx);
+        if (scanner_failed(scanner)) {
+            fprintf(stderr, "Could not read all of %s: stopped at line %d\n",
+                    ctx->filename, scanner_lineno(scanner));
+            result = 1;
+        }
+        scanner_end(scanner);
+        return result;
+    }
+
+    ParseChunk *chunks = calloc((size_t)n, sizeof(ParseChunk));
+    int count = split_lines(in->data, in->len, chunks, n);
+    for (int i = 0; i < count; i++) {
+        chunks[i].kind = opts->scanner;
+        ctx_init(&chunks[i].ctx, ctx->filename);
+    }
+
+    parallel_for((size_t)count, count, parse_chunk, chunks);
+
+    int result = 0;
+    for (int i = 0; i < count; i++) {
+        if (chunks[i].result != 0) {
+            result = chunks[i].result;
+        }
+        // Merged in file order, so first-seen order (and therefore the
+        // IR) matches a sequential parse
+        ctx_merge(ctx, &chunks[i].ctx);
+        ctx_free(&chunks[i].ctx);
+    }
+    free(chunks);
+    return result;
+}
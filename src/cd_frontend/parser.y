@@ -2,26 +2,57 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+%}
+
+%define api.pure full
+%lex-param {Scanner *scanner}
+%parse-param {Scanner *scanner} {CDContext *ctx}
+
+%code requires {
+#include <stddef.h>
+#include "mnemonics.h"
 #include "cd_context.h"
+#include "scanner.h"
+}
 
-extern int yylex(void);
-extern FILE *yyin;
-extern int yylineno;
-void yyerror(const char *s);
-extern CDContext global_ctx;
+%code {
+#include "registers.h"
 
-// Track if we're in a CALL instruction
-static int in_call = 0;
-static char *last_opcode = NULL;
-%}
+void yyerror(Scanner *scanner, CDContext *ctx, const char *s);
+
+// Tokens come from whichever scanner was selected (flex or SIMD)
+static int yylex(YYSTYPE *yylval, Scanner *scanner) {
+    return scanner_lex(yylval, scanner);
+}
+
+// Registers and operand keywords are never APIs: one perfect-hash probe
+static int is_register_or_keyword(const Symbol *tok) {
+    return register_lookup(tok->str, tok->len) >= 0;
+}
+
+static void begin_instruction(CDContext *ctx, Mnemonic op) {
+    ctx_add_opcode(ctx, op);
+    ctx->in_call = (op == MN_CALL);
+    ctx->in_branch = 0;
+}
+}
 
 %union { 
-    char *s; 
+    uint32_t sym;       // Index into ctx->syms
+    Mnemonic op;
+    uint64_t num;
+    struct {
+        uint64_t addr;
+        uint32_t len;   // Encoding bytes listed on the line
+    } loc;
 }
 
-%token <s> OPCODE
-%token <s> IDENT
-%token <s> NUMBER
+%token <op> OPCODE
+%token <sym> IDENT
+%token <sym> LABEL
+%token <sym> SYMREF     // objdump's "<name>" annotation of an address
+%token <loc> ADDRESS    // objdump's "addr:\tbytes" line prefix
+%token <num> NUMBER
 %token NEWLINE
 %token COMMA
 %token COLON
@@ -34,87 +65,86 @@ program
     ;
 
 line
-    : OPCODE operands NEWLINE   { 
-        ctx_add_opcode(&global_ctx, $1);
-        
-        // Set flag if this is a CALL
-        if (strcmp($1, "CALL") == 0) {
-            in_call = 1;
-        } else {
-            in_call = 0;
-        }
-        
-        free($1);
+    : instruction operands NEWLINE
+    | instruction NEWLINE
+    | ADDRESS NEWLINE           {
+        // Continuation of the previous instruction's encoding
+        ctx_extend_insn(ctx, $1.len);
     }
-    | OPCODE NEWLINE            { 
-        ctx_add_opcode(&global_ctx, $1);
-        in_call = 0;
-        free($1); 
-    }
-    | IDENT COLON NEWLINE       { 
+    | LABEL NEWLINE             { 
         // Label definition
-        in_call = 0;
-        free($1); 
+        ctx->in_call = 0;
     }
     | NEWLINE                   {
-        in_call = 0;
+        ctx->in_call = 0;
     }
     | error NEWLINE             {
-        in_call = 0;
+        ctx->in_call = 0;
         yyerrok;
     }
     ;
 
+instruction
+    : OPCODE                    {
+        // Reduced before the operands, so the CALL flag covers this line
+        begin_instruction(ctx, $1);
+    }
+    | ADDRESS OPCODE            {
+        begin_instruction(ctx, $2);
+        ctx_add_insn(ctx, $1.addr, $1.len, $2);
+        ctx->in_branch = (mnemonic_flags[$2] & (MN_F_JUMP | MN_F_CALL)) != 0;
+    }
+    ;
+
 operands
     : operand
     | operands COMMA operand
     ;
 
+// A run of terms, e.g. QWORD PTR [rip+0x2f0e] (brackets and operators
+// are dropped by the scanner) or 140001a30 <main>
 operand
+    : term
+    | operand term
+    ;
+
+term
     : IDENT                     { 
         // ONLY extract as API if:
         // 1. We're in a CALL instruction
         // 2. It's not a register name
         // 3. It's not a memory operand keyword
         
-        if (in_call) {
-            // Check if it's NOT a register
-            if (strcmp($1, "EAX") != 0 && strcmp($1, "EBX") != 0 && 
-                strcmp($1, "ECX") != 0 && strcmp($1, "EDX") != 0 &&
-                strcmp($1, "ESI") != 0 && strcmp($1, "EDI") != 0 &&
-                strcmp($1, "EBP") != 0 && strcmp($1, "ESP") != 0 &&
-                strcmp($1, "RAX") != 0 && strcmp($1, "RBX") != 0 &&
-                strcmp($1, "RCX") != 0 && strcmp($1, "RDX") != 0 &&
-                strcmp($1, "RSI") != 0 && strcmp($1, "RDI") != 0 &&
-                strcmp($1, "RBP") != 0 && strcmp($1, "RSP") != 0 &&
-                strcmp($1, "R8") != 0 && strcmp($1, "R9") != 0 &&
-                strcmp($1, "R10") != 0 && strcmp($1, "R11") != 0 &&
-                strcmp($1, "R12") != 0 && strcmp($1, "R13") != 0 &&
-                strcmp($1, "R14") != 0 && strcmp($1, "R15") != 0 &&
-                strcmp($1, "R8D") != 0 && strcmp($1, "R9D") != 0 &&
-                strcmp($1, "R10D") != 0 && strcmp($1, "R11D") != 0 &&
-                strcmp($1, "R14D") != 0 &&
-                strcmp($1, "QWORD") != 0 && strcmp($1, "DWORD") != 0 &&
-                strcmp($1, "WORD") != 0 && strcmp($1, "BYTE") != 0 &&
-                strcmp($1, "PTR") != 0 && strcmp($1, "RIP") != 0) {
-                
-                // This looks like a real API name or function
-                ctx_add_api(&global_ctx, $1);
-            }
+        if (ctx->in_call && !is_register_or_keyword(&ctx->syms[$1])) {
+            // This looks like a real API name or function
+            ctx_add_api_sym(ctx, $1);
         }
         // Don't add registers/keywords as APIs
-        
-        free($1); 
+        ctx->in_branch = 0;
     }
-    | NUMBER                    { 
-        free($1); 
+    | NUMBER                    {
+        // A branch whose operand starts with a number jumps directly there
+        if (ctx->in_branch) {
+            Insn *insn = &ctx->insns[ctx->insns_len - 1];
+            insn->target = $1;
+            insn->has_target = 1;
+            ctx->in_branch = 0;
+        }
+    }
+    | SYMREF                    {
+        // "call 401000 <CreateFileA@plt>" calls the named symbol
+        if (ctx->in_call) {
+            ctx_add_api_sym(ctx, $1);
+        }
     }
+    | COLON
     ;
 
 %%
 
-void yyerror(const char *s) {
-    if (yylineno <= 10) {  // Only show first few errors
-        fprintf(stderr, "Parse error at line %d: %s\n", yylineno, s);
+void yyerror(Scanner *scanner, CDContext *ctx, const char *s) {
+    int lineno = scanner_lineno(scanner);
+    if (lineno <= 10) {  // Only show first few errors
+        fprintf(stderr, "Parse error in %s at line %d: %s\n", ctx->filename, lineno, s);
     }
 }
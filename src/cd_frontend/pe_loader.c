@@ -0,0 +1,270 @@
+#include "image.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PE_MACHINE_I386         0x014C
+#define PE_MACHINE_AMD64        0x8664
+#define PE_MAGIC_PE32           0x010B
+#define PE_MAGIC_PE32PLUS       0x020B
+#define PE_SCN_CNT_CODE         0x00000020u
+#define PE_SCN_MEM_EXECUTE      0x20000000u
+#define PE_SECTION_HEADER_SIZE  40
+#define PE_DIR_IMPORT           1
+#define PE_DIR_EXCEPTION        3
+#define PE_DIR_DELAY_IMPORT     13
+#define PE_IMPORT_DESC_SIZE     20
+#define PE_DELAY_DESC_SIZE      32
+#define PE_DELAY_RVA_BASED      0x1     // Delay descriptor holds RVAs, not VAs
+#define PE_RUNTIME_FUNCTION_SIZE 12
+#define PE_UNW_FLAG_CHAININFO   0x4
+
+// Sanity bound for corrupt import tables that loop back on themselves
+#define PE_MAX_IMPORTS          65536
+// And for exception directories claiming more entries than code could hold
+#define PE_MAX_FUNCTIONS        (1u << 22)
+
+static uint16_t read_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t read_u32(const uint8_t *p) {
+    return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static uint64_t read_u64(const uint8_t *p) {
+    return read_u32(p) | (uint64_t)read_u32(p + 4) << 32;
+}
+
+// Where rva lies in the file, with *avail bytes readable from there
+static const uint8_t *rva_ptr(const Image *img, uint32_t rva, size_t *avail) {
+    uint64_t va = img->image_base + rva;
+    for (size_t i = 0; i < img->sections_len; i++) {
+        const ImageSection *sec = &img->sections[i];
+        if (va >= sec->vaddr && va - sec->vaddr < sec->size) {
+            *avail = sec->size - (size_t)(va - sec->vaddr);
+            return sec->data + (va - sec->vaddr);
+        }
+    }
+    return NULL;
+}
+
+// Length of the string at p, which may run up to avail bytes unterminated
+static uint32_t str_len(const uint8_t *p, size_t avail) {
+    const uint8_t *nul = memchr(p, 0, avail);
+    return (uint32_t)(nul ? (size_t)(nul - p) : avail);
+}
+
+// Append the functions of one DLL: names from the lookup table at
+// names_rva, slots in the IAT at iat_rva, one pointer-sized entry each
+static void add_dll_imports(Image *img, size_t *cap, uint32_t dll_rva,
+                            uint32_t names_rva, uint32_t iat_rva) {
+    size_t dll_avail, names_avail;
+    const uint8_t *dll = rva_ptr(img, dll_rva, &dll_avail);
+    const uint8_t *names = rva_ptr(img, names_rva ? names_rva : iat_rva, &names_avail);
+    if (!dll || !names) {
+        return;
+    }
+
+    size_t entry = (size_t)img->bits / 8;
+    uint64_t ordinal_flag = (uint64_t)1 << (img->bits - 1);
+    for (size_t i = 0; (i + 1) * entry <= names_avail && img->imports_len < PE_MAX_IMPORTS; i++) {
+        uint64_t thunk = entry == 8 ? read_u64(names + i * entry) : read_u32(names + i * entry);
+        if (thunk == 0) {
+            break;
+        }
+
+        ImageImport imp = {
+            .slot = img->image_base + iat_rva + i * entry,
+            .dll = (const char *)dll,
+            .dll_len = str_len(dll, dll_avail),
+        };
+        if (thunk & ordinal_flag) {
+            imp.ordinal = (uint16_t)thunk;
+        } else {
+            // Hint/name entry: a 2-byte export hint, then the name
+            size_t avail;
+            const uint8_t *hint = rva_ptr(img, (uint32_t)thunk, &avail);
+            if (!hint || avail <= 2) {
+                continue;
+            }
+            imp.name = (const char *)hint + 2;
+            imp.name_len = str_len(hint + 2, avail - 2);
+        }
+
+        if (img->imports_len >= *cap) {
+            *cap = *cap ? *cap * 2 : 64;
+            img->imports = realloc(img->imports, *cap * sizeof(ImageImport));
+        }
+        img->imports[img->imports_len++] = imp;
+    }
+}
+
+static int compare_slots(const void *a, const void *b) {
+    uint64_t x = ((const ImageImport *)a)->slot, y = ((const ImageImport *)b)->slot;
+    return (x > y) - (x < y);
+}
+
+// Regular and delay-load imports. Malformed entries are skipped rather
+// than failing the load: the code can still be analysed without them.
+static void load_imports(Image *img, const uint8_t *dirs, uint32_t num_dirs) {
+    size_t cap = 0, avail;
+
+    if (num_dirs > PE_DIR_IMPORT) {
+        const uint8_t *desc = rva_ptr(img, read_u32(dirs + PE_DIR_IMPORT * 8), &avail);
+        for (; desc && avail >= PE_IMPORT_DESC_SIZE; desc += PE_IMPORT_DESC_SIZE,
+                                                     avail -= PE_IMPORT_DESC_SIZE) {
+            uint32_t names = read_u32(desc), dll = read_u32(desc + 12), iat = read_u32(desc + 16);
+            if (dll == 0 && iat == 0) {
+                break;
+            }
+            add_dll_imports(img, &cap, dll, names, iat);
+        }
+    }
+
+    if (num_dirs > PE_DIR_DELAY_IMPORT) {
+        const uint8_t *desc = rva_ptr(img, read_u32(dirs + PE_DIR_DELAY_IMPORT * 8), &avail);
+        for (; desc && avail >= PE_DELAY_DESC_SIZE; desc += PE_DELAY_DESC_SIZE,
+                                                    avail -= PE_DELAY_DESC_SIZE) {
+            uint32_t attrs = read_u32(desc), dll = read_u32(desc + 4);
+            uint32_t iat = read_u32(desc + 12), names = read_u32(desc + 16);
+            if (dll == 0 && iat == 0) {
+                break;
+            }
+            // Before VC7 the fields were VAs, which only fit in 32 bits
+            if (!(attrs & PE_DELAY_RVA_BASED)) {
+                uint32_t base = (uint32_t)img->image_base;
+                dll -= base;
+                iat -= base;
+                names -= base;
+            }
+            add_dll_imports(img, &cap, dll, names, iat);
+        }
+    }
+
+    if (img->imports_len > 1) {
+        qsort(img->imports, img->imports_len, sizeof(ImageImport), compare_slots);
+    }
+}
+
+// x64 function entries from the exception directory: one RUNTIME_FUNCTION
+// per function, plus one per fragment split off a function (a cold path,
+// say), whose unwind info chains to its parent's. Fragments are skipped.
+static void load_functions(Image *img, const uint8_t *dirs, uint32_t num_dirs) {
+    size_t avail, cap = 0;
+    if (img->bits != 64 || num_dirs <= PE_DIR_EXCEPTION) {
+        return;
+    }
+    const uint8_t *rf = rva_ptr(img, read_u32(dirs + PE_DIR_EXCEPTION * 8), &avail);
+    uint32_t size = read_u32(dirs + PE_DIR_EXCEPTION * 8 + 4);
+    if (!rf) {
+        return;
+    }
+    if (avail > size) {
+        avail = size;
+    }
+
+    for (; avail >= PE_RUNTIME_FUNCTION_SIZE && img->functions_len < PE_MAX_FUNCTIONS;
+         rf += PE_RUNTIME_FUNCTION_SIZE, avail -= PE_RUNTIME_FUNCTION_SIZE) {
+        uint32_t begin = read_u32(rf), unwind = read_u32(rf + 8);
+        size_t info_avail;
+        const uint8_t *info = rva_ptr(img, unwind, &info_avail);
+        // An odd unwind address points straight at the parent's entry;
+        // otherwise the flags sit above the version in the first byte
+        if (begin == 0 || (unwind & 1) || !info ||
+            ((info[0] >> 3) & PE_UNW_FLAG_CHAININFO)) {
+            continue;
+        }
+
+        if (img->functions_len >= cap) {
+            cap = cap ? cap * 2 : 256;
+            img->functions = realloc(img->functions, cap * sizeof(uint64_t));
+        }
+        img->functions[img->functions_len++] = img->image_base + begin;
+    }
+}
+
+// PE32 and PE32+ (x86 and x64) images. Sections are sized the way BFD
+// sizes them, so the disassembled ranges line up with `objdump -d`:
+// the raw data, trimmed to VirtualSize when the file pads it further.
+int pe_load(Image *img, const uint8_t *data, size_t len, char *error, size_t error_len) {
+    size_t pe = read_u32(data + 0x3C);
+    // Signature, file header and the optional header fields read below
+    if (pe > len || len - pe < 24 + 32) {
+        snprintf(error, error_len, "truncated PE header");
+        return -1;
+    }
+
+    const uint8_t *fh = data + pe + 4;
+    uint16_t machine = read_u16(fh);
+    uint16_t num_sections = read_u16(fh + 2);
+    uint16_t opt_size = read_u16(fh + 16);
+    const uint8_t *opt = fh + 20;
+
+    if (machine != PE_MACHINE_I386 && machine != PE_MACHINE_AMD64) {
+        snprintf(error, error_len, "unsupported PE machine 0x%04x", machine);
+        return -1;
+    }
+
+    uint16_t magic = read_u16(opt);
+    size_t dirs_off;
+    if (magic == PE_MAGIC_PE32) {
+        img->bits = 32;
+        img->image_base = read_u32(opt + 28);
+        dirs_off = 92;
+    } else if (magic == PE_MAGIC_PE32PLUS) {
+        img->bits = 64;
+        img->image_base = read_u64(opt + 24);
+        dirs_off = 108;
+    } else {
+        snprintf(error, error_len, "unknown PE optional header magic 0x%04x", magic);
+        return -1;
+    }
+    img->format = IMAGE_PE;
+    img->entry = img->image_base + read_u32(opt + 16);
+
+    size_t table = (size_t)(opt - data) + opt_size;
+    if (table > len || (len - table) / PE_SECTION_HEADER_SIZE < num_sections) {
+        snprintf(error, error_len, "truncated PE section table");
+        return -1;
+    }
+
+    img->sections = calloc(num_sections ? num_sections : 1, sizeof(ImageSection));
+    img->sections_len = num_sections;
+    for (size_t i = 0; i < num_sections; i++) {
+        const uint8_t *sh = data + table + i * PE_SECTION_HEADER_SIZE;
+        uint32_t virtual_size = read_u32(sh + 8);
+        uint32_t virtual_addr = read_u32(sh + 12);
+        uint32_t raw_size = read_u32(sh + 16);
+        uint32_t raw_ptr = read_u32(sh + 20);
+        uint32_t flags = read_u32(sh + 36);
+
+        if (virtual_size > 0 && raw_size > virtual_size) {
+            raw_size = virtual_size;
+        }
+        // A section running past the end of the file keeps what is there
+        if (raw_ptr > len) {
+            raw_size = 0;
+        } else if (raw_size > len - raw_ptr) {
+            raw_size = (uint32_t)(len - raw_ptr);
+        }
+
+        ImageSection *sec = &img->sections[i];
+        memcpy(sec->name, sh, 8);
+        sec->name[8] = '\0';
+        sec->vaddr = img->image_base + virtual_addr;
+        sec->data = data + raw_ptr;
+        sec->size = raw_size;
+        sec->exec = (flags & (PE_SCN_CNT_CODE | PE_SCN_MEM_EXECUTE)) != 0 && raw_size > 0;
+    }
+
+    // NumberOfRvaAndSizes, then the data directories, as far as the
+    // optional header really extends
+    if (opt_size >= dirs_off + 4) {
+        uint32_t num_dirs = read_u32(opt + dirs_off);
+        uint32_t fit = (uint32_t)((opt_size - dirs_off - 4) / 8);
+        load_imports(img, opt + dirs_off + 4, num_dirs < fit ? num_dirs : fit);
+        load_functions(img, opt + dirs_off + 4, num_dirs < fit ? num_dirs : fit);
+    }
+    return 0;
+}
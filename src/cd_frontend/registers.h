@@ -0,0 +1,11 @@
+#ifndef REGISTERS_H
+#define REGISTERS_H
+
+#include <stddef.h>
+
+// Perfect-hash lookup over registers.txt (generated into register_table.c
+// by gen_phash.py). Case-insensitive; returns -1 if s[0..len) is neither
+// an x86/x64 register nor an operand size/addressing keyword.
+int register_lookup(const char *s, size_t len);
+
+#endif // REGISTERS_H
@@ -0,0 +1,410 @@
+#include "rules.h"
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const feature_names[N_NAMED_FEATURES] = {
+    "apis", "named_apis", "cfg.blocks", "cfg.edges", "cfg.branch_density",
+    "cfg.cyclomatic_complexity", "cfg.functions", "cfg.loops", "cfg.max_loop_depth",
+};
+
+static const char *const behaviour_names[N_BEHAVIOURS] = {
+    "network", "fileops", "registry", "memory", "injection", "crypto", "persist",
+};
+
+#define CMP_LESS 1
+#define CMP_EQUAL 2
+#define CMP_GREATER 4
+
+// Comparison operators and the outcomes that satisfy them
+static const struct {
+    const char *op;
+    uint8_t pass;
+} cmp_ops[] = {
+    { "<", CMP_LESS },
+    { "<=", CMP_LESS | CMP_EQUAL },
+    { "==", CMP_EQUAL },
+    { "!=", CMP_LESS | CMP_GREATER },
+    { ">=", CMP_GREATER | CMP_EQUAL },
+    { ">", CMP_GREATER },
+};
+
+// Make room for one more element in a doubling array
+static void reserve(void **items, size_t len, size_t *cap, size_t size) {
+    if (len >= *cap) {
+        *cap = *cap ? *cap * 2 : 16;
+        *items = realloc(*items, *cap * size);
+    }
+}
+
+// State while compiling: the line being read and the API patterns,
+// which are only turned into a matcher at the end
+typedef struct {
+    RuleSet *rs;
+    const char *name;
+    int line;
+    const char *p;      // Next character of the line
+    const char *end;
+    char *error;
+    size_t error_len;
+
+    ApiPattern *patterns;
+    size_t patterns_len, patterns_cap;
+    size_t features_cap, cmps_cap, clauses_cap, rules_cap;
+} Compiler;
+
+static int fail(Compiler *c, const char *fmt, ...) {
+    int n = snprintf(c->error, c->error_len, "%s:%d: ", c->name, c->line);
+    if (n >= 0 && (size_t)n < c->error_len) {
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(c->error + n, c->error_len - n, fmt, ap);
+        va_end(ap);
+    }
+    return -1;
+}
+
+static int is_op_char(char ch) {
+    return ch == '<' || ch == '>' || ch == '=' || ch == '!';
+}
+
+// Next token of the line: a parenthesis, a run of operator characters
+// or a word. Returns its length, 0 at the end of the line or a comment.
+static size_t next_token(Compiler *c, const char **tok) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t')) {
+        c->p++;
+    }
+    if (c->p == c->end || *c->p == '#') {
+        c->p = c->end;
+        *tok = c->end;
+        return 0;
+    }
+
+    const char *start = c->p++;
+    if (*start != '(' && *start != ')') {
+        int op = is_op_char(*start);
+        while (c->p < c->end && *c->p != ' ' && *c->p != '\t' && *c->p != '(' &&
+               *c->p != ')' && *c->p != '#' && is_op_char(*c->p) == op) {
+            c->p++;
+        }
+    }
+    *tok = start;
+    return (size_t)(c->p - start);
+}
+
+static int token_is(const char *tok, size_t len, const char *word) {
+    return strlen(word) == len && strncmp(tok, word, len) == 0;
+}
+
+static int parse_behaviour(Compiler *c, const char *tok, size_t len, uint32_t *mask) {
+    for (int b = 0; b < N_BEHAVIOURS; b++) {
+        if (token_is(tok, len, behaviour_names[b])) {
+            *mask |= 1u << b;
+            return 0;
+        }
+    }
+    return fail(c, "unknown behaviour '%.*s'", (int)len, tok);
+}
+
+// Slot of a feature in rs->feature_source, added on first use
+static int parse_feature(Compiler *c, const char *tok, size_t len, uint16_t *slot) {
+    int32_t source = -1;
+    for (int f = 0; f < N_NAMED_FEATURES; f++) {
+        if (token_is(tok, len, feature_names[f])) {
+            source = f;
+            break;
+        }
+    }
+    if (source < 0) {
+        int op = mnemonic_lookup(tok, len);
+        if (op < 0) {
+            return fail(c, "unknown feature '%.*s'", (int)len, tok);
+        }
+        source = N_NAMED_FEATURES + op;
+    }
+
+    RuleSet *rs = c->rs;
+    size_t f = 0;
+    while (f < rs->features && rs->feature_source[f] != source) {
+        f++;
+    }
+    if (f == rs->features) {
+        reserve((void **)&rs->feature_source, rs->features, &c->features_cap, sizeof(int32_t));
+        rs->feature_source[rs->features++] = source;
+    }
+    *slot = (uint16_t)f;
+    return 0;
+}
+
+// <feature> <op> <number>
+static int parse_comparison(Compiler *c) {
+    RuleSet *rs = c->rs;
+    const char *feature, *tok;
+    size_t feature_len = next_token(c, &feature);
+    uint16_t slot = 0;
+    if (feature_len == 0) {
+        return fail(c, "expected a feature");
+    }
+    if (parse_feature(c, feature, feature_len, &slot) != 0) {
+        return -1;
+    }
+
+    size_t len = next_token(c, &tok);
+    size_t op = 0, n_ops = sizeof(cmp_ops) / sizeof(cmp_ops[0]);
+    while (op < n_ops && !token_is(tok, len, cmp_ops[op].op)) {
+        op++;
+    }
+    if (op == n_ops) {
+        return fail(c, "expected a comparison after '%.*s'", (int)feature_len, feature);
+    }
+
+    len = next_token(c, &tok);
+    char number[64];
+    char *number_end;
+    if (len == 0 || len >= sizeof(number)) {
+        return fail(c, "expected a number");
+    }
+    memcpy(number, tok, len);
+    number[len] = '\0';
+    double value = strtod(number, &number_end);
+    if (*number_end != '\0') {
+        return fail(c, "'%s' is not a number", number);
+    }
+
+    if (rs->cmps == c->cmps_cap) {
+        c->cmps_cap = c->cmps_cap ? c->cmps_cap * 2 : 16;
+        rs->cmp_feature = realloc(rs->cmp_feature, c->cmps_cap * sizeof(uint16_t));
+        rs->cmp_pass = realloc(rs->cmp_pass, c->cmps_cap * sizeof(uint8_t));
+        rs->cmp_value = realloc(rs->cmp_value, c->cmps_cap * sizeof(double));
+    }
+    rs->cmp_feature[rs->cmps] = slot;
+    rs->cmp_pass[rs->cmps] = cmp_ops[op].pass;
+    rs->cmp_value[rs->cmps] = value;
+    rs->cmps++;
+    return 0;
+}
+
+// A comparison, or comparisons joined by "or" in parentheses
+static int parse_clause(Compiler *c) {
+    RuleSet *rs = c->rs;
+    reserve((void **)&rs->clause_start, rs->clauses, &c->clauses_cap, sizeof(uint32_t));
+    rs->clause_start[rs->clauses++] = (uint32_t)rs->cmps;
+
+    const char *save = c->p, *tok;
+    size_t len = next_token(c, &tok);
+    if (!token_is(tok, len, "(")) {
+        c->p = save;
+        return parse_comparison(c);
+    }
+    for (;;) {
+        if (parse_comparison(c) != 0) {
+            return -1;
+        }
+        len = next_token(c, &tok);
+        if (token_is(tok, len, ")")) {
+            return 0;
+        }
+        if (!token_is(tok, len, "or")) {
+            return fail(c, "expected 'or' or ')'");
+        }
+    }
+}
+
+// when <clause> [and <clause>...] then <behaviour>...
+static int parse_when(Compiler *c) {
+    RuleSet *rs = c->rs;
+    if (rs->rules == c->rules_cap) {
+        c->rules_cap = c->rules_cap ? c->rules_cap * 2 : 16;
+        rs->rule_start = realloc(rs->rule_start, c->rules_cap * sizeof(uint32_t));
+        rs->rule_mask = realloc(rs->rule_mask, c->rules_cap * sizeof(uint32_t));
+    }
+    rs->rule_start[rs->rules] = (uint32_t)rs->clauses;
+
+    const char *tok;
+    size_t len;
+    do {
+        if (parse_clause(c) != 0) {
+            return -1;
+        }
+        len = next_token(c, &tok);
+    } while (token_is(tok, len, "and"));
+    if (!token_is(tok, len, "then")) {
+        return fail(c, "expected 'and' or 'then'");
+    }
+
+    uint32_t mask = 0;
+    while ((len = next_token(c, &tok)) != 0) {
+        if (parse_behaviour(c, tok, len, &mask) != 0) {
+            return -1;
+        }
+    }
+    if (mask == 0) {
+        return fail(c, "expected a behaviour after 'then'");
+    }
+    rs->rule_mask[rs->rules++] = mask;
+    return 0;
+}
+
+// api <behaviour> <substring>...
+static int parse_api(Compiler *c) {
+    const char *behaviour, *tok;
+    size_t behaviour_len = next_token(c, &behaviour), len;
+    uint32_t mask = 0;
+    if (behaviour_len == 0) {
+        return fail(c, "expected a behaviour after 'api'");
+    }
+    if (parse_behaviour(c, behaviour, behaviour_len, &mask) != 0) {
+        return -1;
+    }
+
+    size_t added = 0;
+    while ((len = next_token(c, &tok)) != 0) {
+        reserve((void **)&c->patterns, c->patterns_len, &c->patterns_cap, sizeof(ApiPattern));
+        c->patterns[c->patterns_len++] = (ApiPattern){ strndup(tok, len), mask };
+        added++;
+    }
+    if (added == 0) {
+        return fail(c, "expected API substrings after '%.*s'", (int)behaviour_len, behaviour);
+    }
+    return 0;
+}
+
+int rules_compile(RuleSet *rs, const char *text, const char *name,
+                  char *error, size_t error_len) {
+    memset(rs, 0, sizeof(*rs));
+    Compiler c = { .rs = rs, .name = name, .error = error, .error_len = error_len };
+    int status = 0;
+
+    for (const char *line = text; *line && status == 0;) {
+        const char *eol = strchr(line, '\n');
+        c.line++;
+        c.p = line;
+        c.end = eol ? eol : line + strlen(line);
+        if (c.end > line && c.end[-1] == '\r') {
+            c.end--;
+        }
+
+        const char *tok;
+        size_t len = next_token(&c, &tok);
+        if (len == 0) {
+            // Blank or comment
+        } else if (token_is(tok, len, "api")) {
+            status = parse_api(&c);
+        } else if (token_is(tok, len, "when")) {
+            status = parse_when(&c);
+        } else {
+            status = fail(&c, "expected 'api' or 'when', not '%.*s'", (int)len, tok);
+        }
+        line = eol ? eol + 1 : c.end;
+    }
+
+    if (status == 0) {
+        // Closing entries of the clause and rule ranges
+        reserve((void **)&rs->clause_start, rs->clauses, &c.clauses_cap, sizeof(uint32_t));
+        rs->clause_start[rs->clauses] = (uint32_t)rs->cmps;
+        if (rs->rules == c.rules_cap) {
+            rs->rule_start = realloc(rs->rule_start, (rs->rules + 1) * sizeof(uint32_t));
+        }
+        rs->rule_start[rs->rules] = (uint32_t)rs->clauses;
+        api_matcher_build(&rs->apis, c.patterns, c.patterns_len);
+    }
+    for (size_t i = 0; i < c.patterns_len; i++) {
+        free((char *)c.patterns[i].text);
+    }
+    free(c.patterns);
+    if (status != 0) {
+        rules_free(rs);
+    }
+    return status;
+}
+
+int rules_load(RuleSet *rs, const char *path, char *error, size_t error_len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        snprintf(error, error_len, "%s: %s", path, strerror(errno));
+        return -1;
+    }
+
+    size_t len = 0, cap = 4096, n;
+    char *text = malloc(cap);
+    while ((n = fread(text + len, 1, cap - len - 1, f)) > 0) {
+        len += n;
+        if (len + 1 == cap) {
+            cap *= 2;
+            text = realloc(text, cap);
+        }
+    }
+    int read_error = ferror(f);
+    fclose(f);
+    if (read_error) {
+        snprintf(error, error_len, "%s: read error", path);
+        free(text);
+        return -1;
+    }
+    text[len] = '\0';
+
+    int status = rules_compile(rs, text, path, error, error_len);
+    free(text);
+    return status;
+}
+
+void rules_free(RuleSet *rs) {
+    api_matcher_free(&rs->apis);
+    free(rs->feature_source);
+    free(rs->cmp_feature);
+    free(rs->cmp_pass);
+    free(rs->cmp_value);
+    free(rs->clause_start);
+    free(rs->rule_start);
+    free(rs->rule_mask);
+    memset(rs, 0, sizeof(*rs));
+}
+
+static double feature_value(const CDContext *ctx, int32_t source) {
+    switch (source) {
+    case FEATURE_APIS: return (double)ctx->apis_len;
+    case FEATURE_NAMED_APIS: return ctx->named_apis;
+    case FEATURE_CFG_BLOCKS: return ctx->cfg_num_blocks;
+    case FEATURE_CFG_EDGES: return ctx->cfg_num_edges;
+    case FEATURE_CFG_BRANCH_DENSITY: return ctx->cfg_branch_density;
+    case FEATURE_CFG_CYCLOMATIC_COMPLEXITY: return ctx->cfg_cyclomatic_complexity;
+    case FEATURE_CFG_FUNCTIONS: return ctx->cfg_num_functions;
+    case FEATURE_CFG_LOOPS: return ctx->cfg_num_loops;
+    case FEATURE_CFG_MAX_LOOP_DEPTH: return ctx->cfg_max_loop_depth;
+    default: return ctx->opcode_counts[source - N_NAMED_FEATURES];
+    }
+}
+
+// Gather the features once, test every comparison in one branch-free
+// pass over the flat tables, then fold clauses and rules over the results
+uint32_t rules_evaluate(const RuleSet *rs, const CDContext *ctx) {
+    double *values = malloc((rs->features + 1) * sizeof(double));
+    uint8_t *holds = malloc(rs->cmps + 1);
+    for (size_t f = 0; f < rs->features; f++) {
+        values[f] = feature_value(ctx, rs->feature_source[f]);
+    }
+    for (size_t i = 0; i < rs->cmps; i++) {
+        double v = values[rs->cmp_feature[i]], t = rs->cmp_value[i];
+        unsigned outcome = (v < t) * CMP_LESS | (v == t) * CMP_EQUAL | (v > t) * CMP_GREATER;
+        holds[i] = (outcome & rs->cmp_pass[i]) != 0;
+    }
+
+    uint32_t mask = 0;
+    for (size_t r = 0; r < rs->rules; r++) {
+        int all = 1;
+        for (uint32_t cl = rs->rule_start[r]; cl < rs->rule_start[r + 1]; cl++) {
+            int any = 0;
+            for (uint32_t i = rs->clause_start[cl]; i < rs->clause_start[cl + 1]; i++) {
+                any |= holds[i];
+            }
+            all &= any;
+        }
+        mask |= all ? rs->rule_mask[r] : 0;
+    }
+
+    free(values);
+    free(holds);
+    return mask;
+}
@@ -0,0 +1,78 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "api_matcher.h"
+#include "cd_context.h"
+
+// Features a condition can read besides the opcode counts
+typedef enum {
+    FEATURE_APIS,
+    FEATURE_NAMED_APIS,
+    FEATURE_CFG_BLOCKS,
+    FEATURE_CFG_EDGES,
+    FEATURE_CFG_BRANCH_DENSITY,
+    FEATURE_CFG_CYCLOMATIC_COMPLEXITY,
+    FEATURE_CFG_FUNCTIONS,
+    FEATURE_CFG_LOOPS,
+    FEATURE_CFG_MAX_LOOP_DEPTH,
+    N_NAMED_FEATURES
+} NamedFeature;
+
+// Behaviours a rule can set, one bit each in a rule mask
+typedef enum {
+    BEHAVIOUR_NETWORK,
+    BEHAVIOUR_FILEOPS,
+    BEHAVIOUR_REGISTRY,
+    BEHAVIOUR_MEMORY,
+    BEHAVIOUR_INJECTION,
+    BEHAVIOUR_CRYPTO,
+    BEHAVIOUR_PERSIST,
+    N_BEHAVIOURS
+} Behaviour;
+
+// A rules file (format in behaviour.rules) compiled for evaluation
+// without string work: the API substrings into one matcher, and the
+// conditions into flat tables. A rule holds when every one of its
+// clauses does, and a clause when any one of its comparisons does.
+typedef struct {
+    ApiMatcher apis;            // Masks are behaviour bits
+
+    // Features the comparisons read: a named feature, or N_NAMED_FEATURES
+    // plus a Mnemonic for its opcode count
+    size_t features;
+    int32_t *feature_source;
+
+    // Comparisons: value of feature cmp_feature[i] against cmp_value[i];
+    // cmp_pass[i] has bit 0, 1 or 2 set if "less", "equal" or "greater"
+    // satisfies it
+    size_t cmps;
+    uint16_t *cmp_feature;
+    uint8_t *cmp_pass;
+    double *cmp_value;
+
+    // Clause c is comparisons [clause_start[c], clause_start[c + 1])
+    size_t clauses;
+    uint32_t *clause_start;
+
+    // Rule r is clauses [rule_start[r], rule_start[r + 1])
+    size_t rules;
+    uint32_t *rule_start;
+    uint32_t *rule_mask;
+} RuleSet;
+
+// Text of behaviour.rules, generated into default_rules.c
+extern const char default_rules[];
+
+// Compile the rules in text (named name in error messages), or the file
+// at path. Return 0, or -1 with "name:line: reason" written to error.
+int rules_compile(RuleSet *rs, const char *text, const char *name,
+                  char *error, size_t error_len);
+int rules_load(RuleSet *rs, const char *path, char *error, size_t error_len);
+void rules_free(RuleSet *rs);
+
+// Mask of the behaviours the "when" rules set for ctx
+uint32_t rules_evaluate(const RuleSet *rs, const CDContext *ctx);
+
+#endif // RULES_H
@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "parser.tab.h"
+#include "scanner.h"
+#include "simd_scanner.h"
+
+typedef void *yyscan_t;
+
+// lexer.l
+extern yyscan_t lexer_begin(InputBuffer *in, CDContext *ctx);
+extern yyscan_t lexer_begin_bytes(const char *data, size_t len, CDContext *ctx);
+extern yyscan_t lexer_begin_stream(FILE *stream, CDContext *ctx);
+extern void lexer_end(yyscan_t scanner);
+extern int flex_lex(YYSTYPE *lval, yyscan_t scanner);
+extern int yyget_lineno(yyscan_t scanner);
+
+struct Scanner {
+    ScannerKind kind;
+    yyscan_t flex;
+    SimdScanner *simd;
+};
+
+static Scanner *scanner_wrap(ScannerKind kind, yyscan_t flex, SimdScanner *simd) {
+    if (!flex && !simd) {
+        return NULL;
+    }
+
+    Scanner *scanner = malloc(sizeof(Scanner));
+    scanner->kind = kind;
+    scanner->flex = flex;
+    scanner->simd = simd;
+    return scanner;
+}
+
+Scanner *scanner_begin(ScannerKind kind, InputBuffer *in, CDContext *ctx) {
+    if (in->stream) {
+        if (kind == SCANNER_SIMD) {
+            return scanner_wrap(kind, NULL, simd_scanner_begin_stream(in->stream, ctx));
+        }
+        return scanner_wrap(kind, lexer_begin_stream(in->stream, ctx), NULL);
+    }
+    if (kind == SCANNER_SIMD) {
+        return scanner_wrap(kind, NULL, simd_scanner_begin(in->data, in->len, ctx));
+    }
+    return scanner_wrap(kind, lexer_begin(in, ctx), NULL);
+}
+
+// flex has to copy a slice to NUL-terminate it; the SIMD scanner reads
+// it in place
+Scanner *scanner_begin_bytes(ScannerKind kind, const char *data, size_t len, CDContext *ctx) {
+    if (kind == SCANNER_SIMD) {
+        return scanner_wrap(kind, NULL, simd_scanner_begin(data, len, ctx));
+    }
+    return scanner_wrap(kind, lexer_begin_bytes(data, len, ctx), NULL);
+}
+
+void scanner_end(Scanner *scanner) {
+    if (scanner->kind == SCANNER_SIMD) {
+        simd_scanner_end(scanner->simd);
+    } else {
+        lexer_end(scanner->flex);
+    }
+    free(scanner);
+}
+
+int scanner_lex(YYSTYPE *lval, Scanner *scanner) {
+    if (scanner->kind == SCANNER_SIMD) {
+        return simd_scanner_lex(lval, scanner->simd);
+    }
+    return flex_lex(lval, scanner->flex);
+}
+
+int scanner_lineno(const Scanner *scanner) {
+    if (scanner->kind == SCANNER_SIMD) {
+        return simd_scanner_lineno(scanner->simd);
+    }
+    return yyget_lineno(scanner->flex);
+}
+
+int scanner_failed(const Scanner *scanner) {
+    return scanner->kind == SCANNER_SIMD && simd_scanner_failed(scanner->simd);
+}
+
+int scanner_kind_from_name(const char *name, ScannerKind *kind) {
+    if (strcmp(name, "flex") == 0) {
+        *kind = SCANNER_FLEX;
+    } else if (strcmp(name, "simd") == 0) {
+        *kind = SCANNER_SIMD;
+    } else {
+        return -1;
+    }
+    return 0;
+}
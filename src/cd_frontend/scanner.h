@@ -0,0 +1,35 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include <stddef.h>
+#include "cd_context.h"
+#include "input_buffer.h"
+
+// Token source for the parser: either the flex DFA in lexer.l or the
+// hand-written vectorized scanner in simd_scanner.c. Both produce the
+// same token stream for the same input.
+typedef enum {
+    SCANNER_FLEX,
+    SCANNER_SIMD,
+} ScannerKind;
+
+typedef struct Scanner Scanner;
+union YYSTYPE;
+
+// Scan a whole InputBuffer: a mapping in place, a stream through a window
+Scanner *scanner_begin(ScannerKind kind, InputBuffer *in, CDContext *ctx);
+// Scan a slice of a larger buffer [data, data + len)
+Scanner *scanner_begin_bytes(ScannerKind kind, const char *data, size_t len, CDContext *ctx);
+void scanner_end(Scanner *scanner);
+
+int scanner_lex(union YYSTYPE *lval, Scanner *scanner);
+int scanner_lineno(const Scanner *scanner);
+// Nonzero if the input ended early because it could not be read. flex
+// stops the process itself on a read error, so only the SIMD scanner
+// ever reports one.
+int scanner_failed(const Scanner *scanner);
+
+// "flex" or "simd"; returns -1 for anything else
+int scanner_kind_from_name(const char *name, ScannerKind *kind);
+
+#endif // SCANNER_H
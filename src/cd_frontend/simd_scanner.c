@@ -0,0 +1,583 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "parser.tab.h"
+#include "simd_scanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+// Window for streamed input; grows only to hold a longer line
+#define STREAM_WINDOW (64u << 10)
+
+struct SimdScanner {
+    const char *p;
+    const char *end;        // Scan limit; for streams, just past the last whole line read
+    int lineno;
+    int bol;                // At the very start of a line
+    int at_line_start;      // The next word may be a mnemonic or a label
+    int raw;                // On an objdump instruction line: fold words to upper case
+    int failed;             // Stopped before the end of a stream
+    CDContext *ctx;
+
+    // Streamed input only
+    FILE *stream;
+    char *buf;
+    size_t buf_len;
+    size_t buf_cap;
+};
+
+// Byte-class kernels. Each looks at [p, p + n) and returns the length of
+// the leading run of its class (or, for find_newline, the offset of the
+// first '\n'), n if the run reaches the end.
+typedef struct {
+    const char *name;
+    size_t (*span_blank)(const char *p, size_t n);     // [ \t\r]*
+    size_t (*span_ident)(const char *p, size_t n);     // [A-Za-z0-9_]*
+    size_t (*find_newline)(const char *p, size_t n);
+} ScanKernels;
+
+static ScanKernels kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static inline int is_blank(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline int is_digit(unsigned char c) {
+    return (unsigned)(c - '0') < 10u;
+}
+
+static inline int is_alpha(unsigned char c) {
+    return (unsigned)((c | 0x20) - 'a') < 26u || c == '_';
+}
+
+static inline int is_hex_digit(unsigned char c) {
+    return is_digit(c) || (unsigned)((c | 0x20) - 'a') < 6u;
+}
+
+static size_t span_blank_scalar(const char *p, size_t n) {
+    size_t i = 0;
+    while (i < n && is_blank((unsigned char)p[i])) {
+        i++;
+    }
+    return i;
+}
+
+static size_t span_ident_scalar(const char *p, size_t n) {
+    size_t i = 0;
+    while (i < n && (is_alpha((unsigned char)p[i]) || is_digit((unsigned char)p[i]))) {
+        i++;
+    }
+    return i;
+}
+
+static size_t find_newline_scalar(const char *p, size_t n) {
+    const char *nl = memchr(p, '\n', n);
+    return nl ? (size_t)(nl - p) : n;
+}
+
+#ifdef HAVE_X86_KERNELS
+
+// Vector loads never run past the end of the input: the last partial
+// block is always finished by the scalar kernel.
+
+__attribute__((target("sse2")))
+static inline __m128i in_range_sse2(__m128i v, char lo, char hi) {
+    // Unsigned (v - lo) <= (hi - lo), via min since SSE2 lacks unsigned compares
+    __m128i t = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8((char)(hi - lo))), t);
+}
+
+__attribute__((target("sse2")))
+static size_t span_blank_sse2(const char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                              _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('\r')));
+        unsigned other = (unsigned)_mm_movemask_epi8(m) ^ 0xFFFFu;
+        if (other) {
+            return i + (size_t)__builtin_ctz(other);
+        }
+    }
+    return i + span_blank_scalar(p + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static size_t span_ident_sse2(const char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'),
+                                              in_range_sse2(v, '0', '9')),
+                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        unsigned other = (unsigned)_mm_movemask_epi8(m) ^ 0xFFFFu;
+        if (other) {
+            return i + (size_t)__builtin_ctz(other);
+        }
+    }
+    return i + span_ident_scalar(p + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static size_t find_newline_sse2(const char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        unsigned hit = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        if (hit) {
+            return i + (size_t)__builtin_ctz(hit);
+        }
+    }
+    return i + find_newline_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i in_range_avx2(__m256i v, char lo, char hi) {
+    __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8((char)(hi - lo))), t);
+}
+
+__attribute__((target("avx2")))
+static size_t span_blank_avx2(const char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')));
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(m);
+        if (other) {
+            return i + (size_t)__builtin_ctz(other);
+        }
+    }
+    return i + span_blank_sse2(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t span_ident_avx2(const char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(in_range_avx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z'),
+                                                    in_range_avx2(v, '0', '9')),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(m);
+        if (other) {
+            return i + (size_t)__builtin_ctz(other);
+        }
+    }
+    return i + span_ident_sse2(p + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static size_t find_newline_avx2(const char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        unsigned hit = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        if (hit) {
+            return i + (size_t)__builtin_ctz(hit);
+        }
+    }
+    return i + find_newline_sse2(p + i, n - i);
+}
+
+#endif // HAVE_X86_KERNELS
+
+static void select_kernels(void) {
+    kernels = (ScanKernels){ "scalar", span_blank_scalar, span_ident_scalar, find_newline_scalar };
+
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        kernels = (ScanKernels){ "avx2", span_blank_avx2, span_ident_avx2, find_newline_avx2 };
+    } else if (__builtin_cpu_supports("sse2")) {
+        kernels = (ScanKernels){ "sse2", span_blank_sse2, span_ident_sse2, find_newline_sse2 };
+    }
+#endif
+}
+
+const char *simd_scanner_isa(void) {
+    pthread_once(&kernels_once, select_kernels);
+    return kernels.name;
+}
+
+SimdScanner *simd_scanner_begin(const char *data, size_t len, CDContext *ctx) {
+    pthread_once(&kernels_once, select_kernels);
+
+    SimdScanner *s = calloc(1, sizeof(SimdScanner));
+    if (!s) {
+        return NULL;
+    }
+    s->p = data;
+    s->end = data + len;
+    s->lineno = 1;
+    s->bol = 1;
+    s->at_line_start = 1;
+    s->ctx = ctx;
+    return s;
+}
+
+SimdScanner *simd_scanner_begin_stream(FILE *stream, CDContext *ctx) {
+    SimdScanner *s = simd_scanner_begin(NULL, 0, ctx);
+    if (!s) {
+        return NULL;
+    }
+    s->buf_cap = STREAM_WINDOW;
+    s->buf = malloc(s->buf_cap);
+    if (!s->buf) {
+        free(s);
+        return NULL;
+    }
+    s->stream = stream;
+    s->p = s->end = s->buf;
+    return s;
+}
+
+void simd_scanner_end(SimdScanner *s) {
+    free(s->buf);
+    free(s);
+}
+
+// Slide the unscanned partial line to the front of the window and read
+// until at least one more whole line (or the end of the stream) is in.
+// Returns 0 once the stream is exhausted, or if the window cannot grow or
+// the read fails, which leaves the rest unscanned and s->failed set.
+static int refill(SimdScanner *s) {
+    if (!s->stream) {
+        return 0;
+    }
+
+    size_t keep = (size_t)(s->buf + s->buf_len - s->end);
+    memmove(s->buf, s->end, keep);
+    s->buf_len = keep;
+    s->p = s->buf;
+
+    for (;;) {
+        if (s->buf_len == s->buf_cap) {
+            char *grown = realloc(s->buf, s->buf_cap * 2);
+            if (!grown) {
+                s->failed = 1;
+                s->stream = NULL;
+                return 0;
+            }
+            s->buf = grown;
+            s->buf_cap *= 2;
+            s->p = s->buf;
+        }
+
+        size_t n = fread(s->buf + s->buf_len, 1, s->buf_cap - s->buf_len, s->stream);
+        if (n == 0 && ferror(s->stream)) {
+            s->failed = 1;
+            s->stream = NULL;
+            return 0;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        const char *fresh = s->buf + s->buf_len;
+        s->buf_len += n;
+        for (const char *q = fresh + n; q > fresh; q--) {
+            if (q[-1] == '\n') {
+                s->end = q;
+                return 1;
+            }
+        }
+    }
+
+    // End of stream: scan whatever is left, then stop
+    s->stream = NULL;
+    s->end = s->buf + s->buf_len;
+    return s->buf_len > 0;
+}
+
+int simd_scanner_lineno(const SimdScanner *s) {
+    return s->lineno;
+}
+
+int simd_scanner_failed(const SimdScanner *s) {
+    return s->failed;
+}
+
+static size_t span_hex(const char *p, const char *end) {
+    const char *q = p;
+    while (q < end && is_hex_digit((unsigned char)*q)) {
+        q++;
+    }
+    return (size_t)(q - p);
+}
+
+static uint64_t parse_hex(const char *p, size_t len) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)p[i];
+        v = (v << 4) | (is_digit(c) ? (uint64_t)(c - '0') : (uint64_t)((c | 0x20) - 'a' + 10));
+    }
+    return v;
+}
+
+// The number at p, with flex's longest-match choice between [0-9]+,
+// 0x[0-9A-Fa-f]+ and [0-9][0-9A-Fa-f]*[hH], plus bare hex on objdump
+// operands, which wins ties. Returns its length and stores its value.
+static size_t scan_number(const char *p, size_t n, int raw, uint64_t *value) {
+    size_t dec = 1;
+    while (dec < n && is_digit((unsigned char)p[dec])) {
+        dec++;
+    }
+
+    size_t hex = span_hex(p, p + n);
+    size_t suffixed = hex < n && (p[hex] == 'h' || p[hex] == 'H') ? hex + 1 : 0;
+
+    size_t prefixed = 0;
+    if (n > 2 && p[0] == '0' && p[1] == 'x' && is_hex_digit((unsigned char)p[2])) {
+        prefixed = 3 + span_hex(p + 3, p + n);
+    }
+
+    if (prefixed > dec && prefixed > suffixed && (!raw || prefixed > hex)) {
+        *value = parse_hex(p + 2, prefixed - 2);
+        return prefixed;
+    }
+    if (suffixed > dec && (!raw || suffixed > hex)) {
+        *value = parse_hex(p, hex);
+        return suffixed;
+    }
+    if (raw && hex >= dec) {
+        *value = parse_hex(p, hex);
+        return hex;
+    }
+
+    uint64_t v = 0;
+    for (size_t i = 0; i < dec; i++) {
+        v = v * 10 + (uint64_t)(p[i] - '0');
+    }
+    *value = v;
+    return dec;
+}
+
+static int has_prefix(const char *p, const char *end, const char *prefix) {
+    size_t len = strlen(prefix);
+    return (size_t)(end - p) >= len && memcmp(p, prefix, len) == 0;
+}
+
+// The anchored objdump rules of lexer.l, tried once at the start of each
+// line. Returns ADDRESS for an instruction line's address and encoding
+// bytes and LABEL for a symbol header, with *pp moved past them;
+// otherwise 0, with *pp moved past a banner line if there was one.
+static int scan_line_start(SimdScanner *s, const char **pp, YYSTYPE *lval) {
+    const char *p = *pp;
+    const char *end = s->end;
+
+    // "   140001000:\t48 83 ec 28          \tsub    rsp,0x28"
+    const char *q = p;
+    while (q < end && (*q == ' ' || *q == '\t')) {
+        q++;
+    }
+    size_t h = span_hex(q, end);
+    if (h > 0 && end - (q + h) >= 2 && q[h] == ':' && q[h + 1] == '\t') {
+        lval->loc.addr = parse_hex(q, h);
+        q += h + 2;
+        const char *bytes = q;
+        while (end - q >= 3 && is_hex_digit((unsigned char)q[0]) &&
+               is_hex_digit((unsigned char)q[1]) && q[2] == ' ') {
+            q += 3;
+        }
+        lval->loc.len = (uint32_t)((q - bytes) / 3);
+        s->raw = 1;
+        *pp = q;
+        return ADDRESS;
+    }
+
+    // "0000000140001000 <main>:"
+    h = span_hex(p, end);
+    if (h > 0 && end - (p + h) >= 2 && p[h] == ' ' && p[h + 1] == '<') {
+        const char *name = p + h + 2;
+        const char *gt = name;
+        while (gt < end && *gt != '>' && *gt != '\n') {
+            gt++;
+        }
+        if (end - gt >= 2 && gt[0] == '>' && gt[1] == ':') {
+            lval->sym = ctx_intern(s->ctx, name, (size_t)(gt - name));
+            *pp = gt + 2;
+            return LABEL;
+        }
+    }
+
+    // "Disassembly of section .text:" and "foo.exe:     file format pei-x86-64"
+    int banner = has_prefix(p, end, "Disassembly of section ");
+    if (!banner) {
+        q = p;
+        while (q < end && *q != ' ' && *q != '\t' && *q != '\n') {
+            q++;
+        }
+        if (q - p >= 2 && q[-1] == ':' && q < end && *q != '\n') {
+            while (q < end && (*q == ' ' || *q == '\t')) {
+                q++;
+            }
+            banner = has_prefix(q, end, "file format ");
+        }
+    }
+    if (banner) {
+        *pp = p + kernels.find_newline(p, (size_t)(end - p));
+    }
+    return 0;
+}
+
+// "<name>", "<name@plt>" or "<name+0x1e>" at *pp. Returns SYMREF for an
+// exact reference and 0 otherwise, moving *pp past the reference, or past
+// just the '<' if it is never closed on this line.
+static int scan_symref(SimdScanner *s, const char **pp, int fold, YYSTYPE *lval) {
+    const char *name = *pp + 1;
+    const char *gt = name;
+    while (gt < s->end && *gt != '>' && *gt != '\n') {
+        gt++;
+    }
+    if (gt >= s->end || *gt != '>') {
+        *pp = name;
+        return 0;
+    }
+    *pp = gt + 1;
+
+    size_t len = (size_t)(gt - name);
+    if (memchr(name, '+', len) || memchr(name, '-', len)) {
+        return 0;
+    }
+    const char *at = memchr(name, '@', len);
+    if (at) {
+        len = (size_t)(at - name);
+    }
+    if (len == 0) {
+        return 0;
+    }
+    lval->sym = fold ? ctx_intern_upper(s->ctx, name, len) : ctx_intern(s->ctx, name, len);
+    return SYMREF;
+}
+
+// Same rules, in the same order of precedence, as lexer.l
+int simd_scanner_lex(YYSTYPE *lval, SimdScanner *s) {
+    const char *p = s->p;
+    const char *end = s->end;
+
+    for (;;) {
+        if (p >= end) {
+            if (!refill(s)) {
+                s->p = p;
+                return 0;
+            }
+            p = s->p;
+            end = s->end;
+        }
+
+        if (s->bol) {
+            s->bol = 0;
+            int token = scan_line_start(s, &p, lval);
+            if (token) {
+                s->p = p;
+                return token;
+            }
+        }
+
+        p += kernels.span_blank(p, (size_t)(end - p));
+        if (p >= end) {
+            continue;
+        }
+
+        unsigned char c = (unsigned char)*p;
+
+        if (c == '\n') {
+            s->p = p + 1;
+            s->lineno++;
+            s->bol = 1;
+            s->at_line_start = 1;
+            s->raw = 0;
+            return NEWLINE;
+        }
+
+        if (c == ';' || c == '#' || (c == '/' && p + 1 < end && p[1] == '/')) {
+            p += kernels.find_newline(p, (size_t)(end - p));
+            continue;
+        }
+
+        if (c == '.') {
+            // Assembler directive, or a stray dot
+            p++;
+            p += kernels.span_ident(p, (size_t)(end - p));
+            continue;
+        }
+
+        // Operands of an objdump instruction line
+        int raw_operands = s->raw && !s->at_line_start;
+
+        if (is_digit(c)) {
+            p += scan_number(p, (size_t)(end - p), raw_operands, &lval->num);
+            s->p = p;
+            return NUMBER;
+        }
+
+        if (is_alpha(c)) {
+            const char *word = p;
+            size_t len = kernels.span_ident(p, (size_t)(end - p));
+            p += len;
+
+            if (raw_operands && span_hex(word, p) == len) {
+                s->p = p;
+                lval->num = parse_hex(word, len);
+                return NUMBER;
+            }
+
+            if (s->at_line_start) {
+                const char *q = p;
+                while (q < end && (*q == ' ' || *q == '\t')) {
+                    q++;
+                }
+                if (!s->raw && q < end && *q == ':') {
+                    s->p = q + 1;
+                    lval->sym = ctx_intern(s->ctx, word, len);
+                    return LABEL;
+                }
+
+                int op = mnemonic_lookup(word, len);
+                if (op >= 0) {
+                    s->p = p;
+                    s->at_line_start = 0;
+                    lval->op = (Mnemonic)op;
+                    return OPCODE;
+                }
+                if (prefix_lookup(word, len) >= 0) {
+                    continue;
+                }
+                s->at_line_start = 0;
+            }
+
+            s->p = p;
+            lval->sym = s->raw ? ctx_intern_upper(s->ctx, word, len) : ctx_intern(s->ctx, word, len);
+            return IDENT;
+        }
+
+        if (c == '<') {
+            int token = scan_symref(s, &p, raw_operands, lval);
+            if (token) {
+                s->p = p;
+                return token;
+            }
+            continue;
+        }
+
+        p++;
+        if (c == ',') {
+            s->p = p;
+            return COMMA;
+        }
+        if (c == ':') {
+            s->p = p;
+            return COLON;
+        }
+        // Brackets, operators and anything else are ignored
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef SIMD_SCANNER_H
+#define SIMD_SCANNER_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "cd_context.h"
+
+// Hand-written scanner for the same token language as lexer.l. Newlines,
+// blanks, comment bodies and identifier characters are found 16 or 32
+// bytes at a time with SSE2/AVX2, chosen at run time from the CPU's
+// features, with a scalar fallback everywhere else.
+//
+// The input needs no terminator and is never written to, so slices of a
+// shared buffer can be scanned in place. Streams are read through a
+// window that only ever holds whole lines.
+typedef struct SimdScanner SimdScanner;
+union YYSTYPE;
+
+SimdScanner *simd_scanner_begin(const char *data, size_t len, CDContext *ctx);
+SimdScanner *simd_scanner_begin_stream(FILE *stream, CDContext *ctx);
+int simd_scanner_lex(union YYSTYPE *lval, SimdScanner *scanner);
+int simd_scanner_lineno(const SimdScanner *scanner);
+// Nonzero if a stream could not be read to its end (out of memory for a
+// long line, or a read error); lex has returned end of input early
+int simd_scanner_failed(const SimdScanner *scanner);
+void simd_scanner_end(SimdScanner *scanner);
+
+// Name of the kernel set in use ("avx2", "sse2" or "scalar")
+const char *simd_scanner_isa(void);
+
+#endif // SIMD_SCANNER_H
@@ -0,0 +1,52 @@
+#include "thread_pool.h"
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef struct {
+    size_t n;
+    atomic_size_t next;
+    void (*fn)(size_t i, void *arg);
+    void *arg;
+} ParallelFor;
+
+static void *parallel_for_worker(void *p) {
+    ParallelFor *pf = p;
+
+    for (;;) {
+        size_t i = atomic_fetch_add(&pf->next, 1);
+        if (i >= pf->n) {
+            break;
+        }
+        pf->fn(i, pf->arg);
+    }
+    return NULL;
+}
+
+void parallel_for(size_t n, int num_threads, void (*fn)(size_t i, void *arg), void *arg) {
+    ParallelFor pf = { .n = n, .fn = fn, .arg = arg };
+    atomic_init(&pf.next, 0);
+
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    if ((size_t)num_threads > n) {
+        num_threads = n > 0 ? (int)n : 1;
+    }
+
+    // The calling thread takes part; if a thread cannot be started the
+    // remaining workers simply pick up its share
+    pthread_t *threads = calloc((size_t)num_threads, sizeof(pthread_t));
+    int started = 1;
+    for (int t = 1; t < num_threads; t++) {
+        if (pthread_create(&threads[t], NULL, parallel_for_worker, &pf) != 0) {
+            break;
+        }
+        started++;
+    }
+    parallel_for_worker(&pf);
+    for (int t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+}
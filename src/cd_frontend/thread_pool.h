@@ -0,0 +1,11 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+// Run fn(i, arg) for every i in [0, n) on up to num_threads threads
+// (the calling thread included). Indices are handed out dynamically, so
+// uneven items balance themselves. Returns once every call has finished.
+void parallel_for(size_t n, int num_threads, void (*fn)(size_t i, void *arg), void *arg);
+
+#endif // THREAD_POOL_H
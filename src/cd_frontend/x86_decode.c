@@ -0,0 +1,1696 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "mnemonics.h"
+#include "x86_decode.h"
+
+// Opcode tables for the legacy one-byte map and the 0F, 0F38 and 0F3A
+// maps, indexed by opcode byte. VEX and EVEX instructions reuse them: the
+// VEX form of an SSE instruction is the same opcode with a "V" in front
+// of its name, so only VEX- and EVEX-only instructions are listed apart.
+//
+// Entries follow binutils' i386-dis.c rather than the SDM where the two
+// disagree, since the point is to count exactly what `objdump -d` prints.
+
+#define NA      (-2)    // No such form: the prefix selects nothing
+#define UNK     X86_OP_UNKNOWN  // Valid, but not a name in mnemonics.def
+
+// Operand layout flags
+#define F_OK    0x01    // Defined opcode
+#define F_MODRM 0x02    // A ModRM byte (and any SIB/displacement) follows
+#define F_SSE   0x04    // mn[] is indexed by mandatory prefix
+#define F_INV64 0x08    // "(bad)" in 64-bit mode
+#define F_MODREG 0x10   // ModRM names registers whatever its mod field
+#define F_MEM   0x20    // "(bad)" with a register operand (mod == 3)
+#define F_NOMEM 0x40    // "(bad)" with a memory operand
+#define F_REGOP 0x80    // As F_NOMEM, but objdump keeps the name and
+                        // consumes only the prefixes and one opcode byte
+#define F_MEMOP 0x100   // The same for a register operand
+#define F_W16   0x200   // Spelled with a "w" suffix under a 66 prefix
+#define F_W16_64 0x400  // The same, in 64-bit mode only
+
+// Immediate operand kinds
+enum {
+    I_NONE,
+    I_B,        // imm8
+    I_W,        // imm16
+    I_Z,        // imm16 or imm32, by operand size
+    I_V,        // imm16, imm32 or imm64, by operand size
+    I_J8,       // rel8
+    I_JZ,       // rel16 or rel32
+    I_MOFFS,    // Address-sized offset
+    I_ENTER,    // imm16 + imm8
+    I_FAR,      // ptr16:16 or ptr16:32
+};
+
+// Mandatory-prefix columns of mn[], and VEX.pp
+enum { P_NONE, P_66, P_F3, P_F2 };
+
+typedef struct {
+    int16_t mn[4];      // Mnemonic, or mn[P_NONE] only without F_SSE
+    uint16_t flags;
+    uint8_t imm;
+    uint8_t group;      // Nonzero: the ModRM reg field picks from groups[]
+} OpInfo;
+
+typedef struct {
+    int16_t mn;         // NA is "(bad)"
+    uint8_t imm;
+} GroupOp;
+
+#define OP(m, fl, im)           { { MN_##m, NA, NA, NA }, F_OK | (fl), (im), 0 }
+#define OPU(fl, im)             { { UNK, NA, NA, NA }, F_OK | (fl), (im), 0 }
+#define SSE(a, b, c, d, im)     { { a, b, c, d }, F_OK | F_MODRM | F_SSE, (im), 0 }
+#define SSEF(a, b, c, d, fl, im) { { a, b, c, d }, F_OK | F_MODRM | F_SSE | (fl), (im), 0 }
+#define SSE0(a, b, c, d)        { { a, b, c, d }, F_OK | F_SSE, I_NONE, 0 }
+#define MMX(m, im)              SSE(MN_##m, MN_##m, NA, NA, im)
+#define GRP(g, fl, im)          { { UNK, NA, NA, NA }, F_OK | F_MODRM | (fl), (im), (g) }
+#define M(m)                    MN_##m
+
+#define G(m)                    { MN_##m, I_NONE }
+#define GI(m, im)               { MN_##m, (im) }
+#define GU                      { UNK, I_NONE }
+#define GB                      { NA, I_NONE }
+
+enum {
+    G_NONE,
+    G_1,        // 80-83
+    G_1A,       // 8F
+    G_2,        // C0, C1, D0-D3
+    G_3B,       // F6
+    G_3Z,       // F7
+    G_4,        // FE
+    G_5,        // FF
+    G_11B,      // C6
+    G_11Z,      // C7
+    G_6,        // 0F 00
+    G_7,        // 0F 01
+    G_8,        // 0F BA
+    G_9,        // 0F C7
+    G_12,       // 0F 71
+    G_13,       // 0F 72
+    G_14,       // 0F 73
+    G_15,       // 0F AE
+    G_16,       // 0F 18
+    G_P,        // 0F 0D
+    N_GROUPS
+};
+
+// [group][mod == 3][reg]
+static const GroupOp groups[N_GROUPS][2][8] = {
+    [G_1] = {
+        { G(ADD), G(OR), G(ADC), G(SBB), G(AND), G(SUB), G(XOR), G(CMP) },
+        { G(ADD), G(OR), G(ADC), G(SBB), G(AND), G(SUB), G(XOR), G(CMP) },
+    },
+    [G_1A] = {
+        { G(POP), GB, GB, GB, GB, GB, GB, GB },
+        { G(POP), GB, GB, GB, GB, GB, GB, GB },
+    },
+    [G_2] = {
+        { G(ROL), G(ROR), G(RCL), G(RCR), G(SHL), G(SHR), G(SHL), G(SAR) },
+        { G(ROL), G(ROR), G(RCL), G(RCR), G(SHL), G(SHR), G(SHL), G(SAR) },
+    },
+    [G_3B] = {
+        { GI(TEST, I_B), GI(TEST, I_B), G(NOT), G(NEG), G(MUL), G(IMUL), G(DIV), G(IDIV) },
+        { GI(TEST, I_B), GI(TEST, I_B), G(NOT), G(NEG), G(MUL), G(IMUL), G(DIV), G(IDIV) },
+    },
+    [G_3Z] = {
+        { GI(TEST, I_Z), GI(TEST, I_Z), G(NOT), G(NEG), G(MUL), G(IMUL), G(DIV), G(IDIV) },
+        { GI(TEST, I_Z), GI(TEST, I_Z), G(NOT), G(NEG), G(MUL), G(IMUL), G(DIV), G(IDIV) },
+    },
+    [G_4] = {
+        { G(INC), G(DEC), GB, GB, GB, GB, GB, GB },
+        { G(INC), G(DEC), GB, GB, GB, GB, GB, GB },
+    },
+    [G_5] = {
+        { G(INC), G(DEC), G(CALL), G(CALL), G(JMP), G(JMP), G(PUSH), GB },
+        { G(INC), G(DEC), G(CALL), GB, G(JMP), GB, G(PUSH), GB },
+    },
+    [G_11B] = {
+        { GI(MOV, I_B), GB, GB, GB, GB, GB, GB, GB },
+        { GI(MOV, I_B), GB, GB, GB, GB, GB, GB, GI(XABORT, I_B) },
+    },
+    [G_11Z] = {
+        { GI(MOV, I_Z), GB, GB, GB, GB, GB, GB, GB },
+        { GI(MOV, I_Z), GB, GB, GB, GB, GB, GB, GI(XBEGIN, I_JZ) },
+    },
+    [G_6] = {
+        { G(SLDT), G(STR), G(LLDT), G(LTR), G(VERR), G(VERW), GB, GB },
+        { G(SLDT), G(STR), G(LLDT), G(LTR), G(VERR), G(VERW), GB, GB },
+    },
+    [G_7] = {
+        { G(SGDT), G(SIDT), G(LGDT), G(LIDT), G(SMSW), GB, G(LMSW), G(INVLPG) },
+        { GU, GU, GU, GU, G(SMSW), GU, G(LMSW), GU },    // Refined by modrm in decode_0f01
+    },
+    [G_8] = {
+        { GB, GB, GB, GB, GI(BT, I_B), GI(BTS, I_B), GI(BTR, I_B), GI(BTC, I_B) },
+        { GB, GB, GB, GB, GI(BT, I_B), GI(BTS, I_B), GI(BTR, I_B), GI(BTC, I_B) },
+    },
+    [G_9] = {
+        { GB, G(CMPXCHG8B), GB, G(XRSTORS), G(XSAVEC), G(XSAVES), G(VMPTRLD), G(VMPTRST) },
+        { GB, G(CMPXCHG8B), GB, GB, GB, GB, G(RDRAND), G(RDSEED) },
+    },
+    [G_12] = {
+        { GB, GB, GB, GB, GB, GB, GB, GB },
+        { GB, GB, GI(PSRLW, I_B), GB, GI(PSRAW, I_B), GB, GI(PSLLW, I_B), GB },
+    },
+    [G_13] = {
+        { GB, GB, GB, GB, GB, GB, GB, GB },
+        { GB, GB, GI(PSRLD, I_B), GB, GI(PSRAD, I_B), GB, GI(PSLLD, I_B), GB },
+    },
+    [G_14] = {
+        { GB, GB, GB, GB, GB, GB, GB, GB },
+        { GB, GB, GI(PSRLQ, I_B), GI(PSRLDQ, I_B), GB, GB, GI(PSLLQ, I_B), GI(PSLLDQ, I_B) },
+    },
+    [G_15] = {
+        { G(FXSAVE), G(FXRSTOR), G(LDMXCSR), G(STMXCSR), G(XSAVE), G(XRSTOR), G(XSAVEOPT), G(CLFLUSH) },
+        { GB, GB, GB, GB, GB, G(LFENCE), G(MFENCE), G(SFENCE) },
+    },
+    [G_16] = {
+        { G(PREFETCHNTA), G(PREFETCHT0), G(PREFETCHT1), G(PREFETCHT2), G(NOP), G(NOP), G(NOP), G(NOP) },
+        { G(NOP), G(NOP), G(NOP), G(NOP), G(NOP), G(NOP), G(NOP), G(NOP) },
+    },
+    [G_P] = {
+        { G(PREFETCH), G(PREFETCHW), G(PREFETCHWT1), G(PREFETCH), G(PREFETCH), G(PREFETCH), G(PREFETCH), G(PREFETCH) },
+        { G(PREFETCH), G(PREFETCHW), G(PREFETCHWT1), G(PREFETCH), G(PREFETCH), G(PREFETCH), G(PREFETCH), G(PREFETCH) },
+    },
+};
+
+static const OpInfo map_1byte[256] = {
+    [0x00] = OP(ADD, F_MODRM, I_NONE), [0x01] = OP(ADD, F_MODRM, I_NONE),
+    [0x02] = OP(ADD, F_MODRM, I_NONE), [0x03] = OP(ADD, F_MODRM, I_NONE),
+    [0x04] = OP(ADD, 0, I_B), [0x05] = OP(ADD, 0, I_Z),
+    [0x06] = OP(PUSH, F_INV64 | F_W16, I_NONE), [0x07] = OP(POP, F_INV64 | F_W16, I_NONE),
+    [0x08] = OP(OR, F_MODRM, I_NONE), [0x09] = OP(OR, F_MODRM, I_NONE),
+    [0x0A] = OP(OR, F_MODRM, I_NONE), [0x0B] = OP(OR, F_MODRM, I_NONE),
+    [0x0C] = OP(OR, 0, I_B), [0x0D] = OP(OR, 0, I_Z),
+    [0x0E] = OP(PUSH, F_INV64 | F_W16, I_NONE),
+    [0x10] = OP(ADC, F_MODRM, I_NONE), [0x11] = OP(ADC, F_MODRM, I_NONE),
+    [0x12] = OP(ADC, F_MODRM, I_NONE), [0x13] = OP(ADC, F_MODRM, I_NONE),
+    [0x14] = OP(ADC, 0, I_B), [0x15] = OP(ADC, 0, I_Z),
+    [0x16] = OP(PUSH, F_INV64 | F_W16, I_NONE), [0x17] = OP(POP, F_INV64 | F_W16, I_NONE),
+    [0x18] = OP(SBB, F_MODRM, I_NONE), [0x19] = OP(SBB, F_MODRM, I_NONE),
+    [0x1A] = OP(SBB, F_MODRM, I_NONE), [0x1B] = OP(SBB, F_MODRM, I_NONE),
+    [0x1C] = OP(SBB, 0, I_B), [0x1D] = OP(SBB, 0, I_Z),
+    [0x1E] = OP(PUSH, F_INV64 | F_W16, I_NONE), [0x1F] = OP(POP, F_INV64 | F_W16, I_NONE),
+    [0x20] = OP(AND, F_MODRM, I_NONE), [0x21] = OP(AND, F_MODRM, I_NONE),
+    [0x22] = OP(AND, F_MODRM, I_NONE), [0x23] = OP(AND, F_MODRM, I_NONE),
+    [0x24] = OP(AND, 0, I_B), [0x25] = OP(AND, 0, I_Z),
+    [0x27] = OP(DAA, F_INV64, I_NONE),
+    [0x28] = OP(SUB, F_MODRM, I_NONE), [0x29] = OP(SUB, F_MODRM, I_NONE),
+    [0x2A] = OP(SUB, F_MODRM, I_NONE), [0x2B] = OP(SUB, F_MODRM, I_NONE),
+    [0x2C] = OP(SUB, 0, I_B), [0x2D] = OP(SUB, 0, I_Z),
+    [0x2F] = OP(DAS, F_INV64, I_NONE),
+    [0x30] = OP(XOR, F_MODRM, I_NONE), [0x31] = OP(XOR, F_MODRM, I_NONE),
+    [0x32] = OP(XOR, F_MODRM, I_NONE), [0x33] = OP(XOR, F_MODRM, I_NONE),
+    [0x34] = OP(XOR, 0, I_B), [0x35] = OP(XOR, 0, I_Z),
+    [0x37] = OP(AAA, F_INV64, I_NONE),
+    [0x38] = OP(CMP, F_MODRM, I_NONE), [0x39] = OP(CMP, F_MODRM, I_NONE),
+    [0x3A] = OP(CMP, F_MODRM, I_NONE), [0x3B] = OP(CMP, F_MODRM, I_NONE),
+    [0x3C] = OP(CMP, 0, I_B), [0x3D] = OP(CMP, 0, I_Z),
+    [0x3F] = OP(AAS, F_INV64, I_NONE),
+    // 40-4F are REX prefixes in 64-bit mode
+    [0x40] = OP(INC, 0, I_NONE), [0x41] = OP(INC, 0, I_NONE),
+    [0x42] = OP(INC, 0, I_NONE), [0x43] = OP(INC, 0, I_NONE),
+    [0x44] = OP(INC, 0, I_NONE), [0x45] = OP(INC, 0, I_NONE),
+    [0x46] = OP(INC, 0, I_NONE), [0x47] = OP(INC, 0, I_NONE),
+    [0x48] = OP(DEC, 0, I_NONE), [0x49] = OP(DEC, 0, I_NONE),
+    [0x4A] = OP(DEC, 0, I_NONE), [0x4B] = OP(DEC, 0, I_NONE),
+    [0x4C] = OP(DEC, 0, I_NONE), [0x4D] = OP(DEC, 0, I_NONE),
+    [0x4E] = OP(DEC, 0, I_NONE), [0x4F] = OP(DEC, 0, I_NONE),
+    [0x50] = OP(PUSH, 0, I_NONE), [0x51] = OP(PUSH, 0, I_NONE),
+    [0x52] = OP(PUSH, 0, I_NONE), [0x53] = OP(PUSH, 0, I_NONE),
+    [0x54] = OP(PUSH, 0, I_NONE), [0x55] = OP(PUSH, 0, I_NONE),
+    [0x56] = OP(PUSH, 0, I_NONE), [0x57] = OP(PUSH, 0, I_NONE),
+    [0x58] = OP(POP, 0, I_NONE), [0x59] = OP(POP, 0, I_NONE),
+    [0x5A] = OP(POP, 0, I_NONE), [0x5B] = OP(POP, 0, I_NONE),
+    [0x5C] = OP(POP, 0, I_NONE), [0x5D] = OP(POP, 0, I_NONE),
+    [0x5E] = OP(POP, 0, I_NONE), [0x5F] = OP(POP, 0, I_NONE),
+    [0x60] = OP(PUSHA, F_INV64, I_NONE), [0x61] = OP(POPA, F_INV64, I_NONE),
+    [0x62] = OP(BOUND, F_MODRM | F_INV64, I_NONE),
+    [0x63] = OP(ARPL, F_MODRM, I_NONE),
+    [0x68] = OP(PUSH, F_W16, I_Z), [0x69] = OP(IMUL, F_MODRM, I_Z),
+    [0x6A] = OP(PUSH, F_W16, I_B), [0x6B] = OP(IMUL, F_MODRM, I_B),
+    [0x6C] = OP(INS, 0, I_NONE), [0x6D] = OP(INS, 0, I_NONE),
+    [0x6E] = OP(OUTS, 0, I_NONE), [0x6F] = OP(OUTS, 0, I_NONE),
+    [0x70] = OP(JO, 0, I_J8), [0x71] = OP(JNO, 0, I_J8),
+    [0x72] = OP(JB, 0, I_J8), [0x73] = OP(JAE, 0, I_J8),
+    [0x74] = OP(JE, 0, I_J8), [0x75] = OP(JNE, 0, I_J8),
+    [0x76] = OP(JBE, 0, I_J8), [0x77] = OP(JA, 0, I_J8),
+    [0x78] = OP(JS, 0, I_J8), [0x79] = OP(JNS, 0, I_J8),
+    [0x7A] = OP(JP, 0, I_J8), [0x7B] = OP(JNP, 0, I_J8),
+    [0x7C] = OP(JL, 0, I_J8), [0x7D] = OP(JGE, 0, I_J8),
+    [0x7E] = OP(JLE, 0, I_J8), [0x7F] = OP(JG, 0, I_J8),
+    [0x80] = GRP(G_1, 0, I_B), [0x81] = GRP(G_1, 0, I_Z),
+    [0x82] = GRP(G_1, F_INV64, I_B), [0x83] = GRP(G_1, 0, I_B),
+    [0x84] = OP(TEST, F_MODRM, I_NONE), [0x85] = OP(TEST, F_MODRM, I_NONE),
+    [0x86] = OP(XCHG, F_MODRM, I_NONE), [0x87] = OP(XCHG, F_MODRM, I_NONE),
+    [0x88] = OP(MOV, F_MODRM, I_NONE), [0x89] = OP(MOV, F_MODRM, I_NONE),
+    [0x8A] = OP(MOV, F_MODRM, I_NONE), [0x8B] = OP(MOV, F_MODRM, I_NONE),
+    [0x8C] = OP(MOV, F_MODRM, I_NONE), [0x8D] = OP(LEA, F_MODRM | F_MEM, I_NONE),
+    [0x8E] = OP(MOV, F_MODRM, I_NONE), [0x8F] = GRP(G_1A, 0, I_NONE),
+    [0x90] = OP(NOP, 0, I_NONE), [0x91] = OP(XCHG, 0, I_NONE),
+    [0x92] = OP(XCHG, 0, I_NONE), [0x93] = OP(XCHG, 0, I_NONE),
+    [0x94] = OP(XCHG, 0, I_NONE), [0x95] = OP(XCHG, 0, I_NONE),
+    [0x96] = OP(XCHG, 0, I_NONE), [0x97] = OP(XCHG, 0, I_NONE),
+    [0x98] = OP(CWDE, 0, I_NONE), [0x99] = OP(CDQ, 0, I_NONE),
+    [0x9A] = OP(CALL, F_INV64, I_FAR), [0x9B] = OP(FWAIT, 0, I_NONE),
+    [0x9C] = OP(PUSHF, 0, I_NONE), [0x9D] = OP(POPF, 0, I_NONE),
+    [0x9E] = OP(SAHF, 0, I_NONE), [0x9F] = OP(LAHF, 0, I_NONE),
+    [0xA0] = OP(MOV, 0, I_MOFFS), [0xA1] = OP(MOV, 0, I_MOFFS),
+    [0xA2] = OP(MOV, 0, I_MOFFS), [0xA3] = OP(MOV, 0, I_MOFFS),
+    [0xA4] = OP(MOVS, 0, I_NONE), [0xA5] = OP(MOVS, 0, I_NONE),
+    [0xA6] = OP(CMPS, 0, I_NONE), [0xA7] = OP(CMPS, 0, I_NONE),
+    [0xA8] = OP(TEST, 0, I_B), [0xA9] = OP(TEST, 0, I_Z),
+    [0xAA] = OP(STOS, 0, I_NONE), [0xAB] = OP(STOS, 0, I_NONE),
+    [0xAC] = OP(LODS, 0, I_NONE), [0xAD] = OP(LODS, 0, I_NONE),
+    [0xAE] = OP(SCAS, 0, I_NONE), [0xAF] = OP(SCAS, 0, I_NONE),
+    [0xB0] = OP(MOV, 0, I_B), [0xB1] = OP(MOV, 0, I_B),
+    [0xB2] = OP(MOV, 0, I_B), [0xB3] = OP(MOV, 0, I_B),
+    [0xB4] = OP(MOV, 0, I_B), [0xB5] = OP(MOV, 0, I_B),
+    [0xB6] = OP(MOV, 0, I_B), [0xB7] = OP(MOV, 0, I_B),
+    [0xB8] = OP(MOV, 0, I_V), [0xB9] = OP(MOV, 0, I_V),
+    [0xBA] = OP(MOV, 0, I_V), [0xBB] = OP(MOV, 0, I_V),
+    [0xBC] = OP(MOV, 0, I_V), [0xBD] = OP(MOV, 0, I_V),
+    [0xBE] = OP(MOV, 0, I_V), [0xBF] = OP(MOV, 0, I_V),
+    [0xC0] = GRP(G_2, 0, I_B), [0xC1] = GRP(G_2, 0, I_B),
+    [0xC2] = OP(RET, F_W16, I_W), [0xC3] = OP(RET, F_W16, I_NONE),
+    [0xC4] = OP(LES, F_MODRM | F_INV64, I_NONE), [0xC5] = OP(LDS, F_MODRM | F_INV64, I_NONE),
+    [0xC6] = GRP(G_11B, 0, I_NONE), [0xC7] = GRP(G_11Z, 0, I_NONE),
+    [0xC8] = OP(ENTER, F_W16, I_ENTER), [0xC9] = OP(LEAVE, F_W16, I_NONE),
+    [0xCA] = OP(RETF, F_W16, I_W), [0xCB] = OP(RETF, F_W16, I_NONE),
+    [0xCC] = OP(INT3, 0, I_NONE), [0xCD] = OP(INT, 0, I_B),
+    [0xCE] = OP(INTO, F_INV64, I_NONE), [0xCF] = OP(IRET, 0, I_NONE),
+    [0xD0] = GRP(G_2, 0, I_NONE), [0xD1] = GRP(G_2, 0, I_NONE),
+    [0xD2] = GRP(G_2, 0, I_NONE), [0xD3] = GRP(G_2, 0, I_NONE),
+    [0xD4] = OP(AAM, F_INV64, I_B), [0xD5] = OP(AAD, F_INV64, I_B),
+    [0xD6] = OPU(F_INV64, I_NONE), [0xD7] = OP(XLAT, 0, I_NONE),
+    // D8-DF (x87) are decoded by decode_x87
+    [0xE0] = OP(LOOPNE, 0, I_J8), [0xE1] = OP(LOOPE, 0, I_J8),
+    [0xE2] = OP(LOOP, 0, I_J8), [0xE3] = OP(JECXZ, 0, I_J8),
+    [0xE4] = OP(IN, 0, I_B), [0xE5] = OP(IN, 0, I_B),
+    [0xE6] = OP(OUT, 0, I_B), [0xE7] = OP(OUT, 0, I_B),
+    [0xE8] = OP(CALL, F_W16_64, I_JZ), [0xE9] = OP(JMP, F_W16_64, I_JZ),
+    [0xEA] = OP(JMP, F_INV64, I_FAR), [0xEB] = OP(JMP, 0, I_J8),
+    [0xEC] = OP(IN, 0, I_NONE), [0xED] = OP(IN, 0, I_NONE),
+    [0xEE] = OP(OUT, 0, I_NONE), [0xEF] = OP(OUT, 0, I_NONE),
+    [0xF1] = OP(INT1, 0, I_NONE),
+    [0xF4] = OP(HLT, 0, I_NONE), [0xF5] = OP(CMC, 0, I_NONE),
+    [0xF6] = GRP(G_3B, 0, I_NONE), [0xF7] = GRP(G_3Z, 0, I_NONE),
+    [0xF8] = OP(CLC, 0, I_NONE), [0xF9] = OP(STC, 0, I_NONE),
+    [0xFA] = OP(CLI, 0, I_NONE), [0xFB] = OP(STI, 0, I_NONE),
+    [0xFC] = OP(CLD, 0, I_NONE), [0xFD] = OP(STD, 0, I_NONE),
+    [0xFE] = GRP(G_4, 0, I_NONE), [0xFF] = GRP(G_5, 0, I_NONE),
+};
+
+static const OpInfo map_0f[256] = {
+    [0x00] = GRP(G_6, 0, I_NONE), [0x01] = GRP(G_7, 0, I_NONE),
+    [0x02] = OP(LAR, F_MODRM, I_NONE), [0x03] = OP(LSL, F_MODRM, I_NONE),
+    [0x05] = OP(SYSCALL, 0, I_NONE), [0x06] = OP(CLTS, 0, I_NONE),
+    [0x07] = OP(SYSRET, 0, I_NONE), [0x08] = OP(INVD, 0, I_NONE),
+    [0x09] = SSE0(M(WBINVD), NA, UNK, NA), [0x0B] = OP(UD2, 0, I_NONE),
+    [0x0D] = GRP(G_P, F_MEMOP, I_NONE), [0x0E] = OPU(0, I_NONE),
+    [0x0F] = OPU(F_MODRM, I_B),     // 3DNow!, suffix byte read as an immediate
+    [0x10] = SSE(M(MOVUPS), M(MOVUPD), M(MOVSS), M(MOVSD), I_NONE),
+    [0x11] = SSE(M(MOVUPS), M(MOVUPD), M(MOVSS), M(MOVSD), I_NONE),
+    [0x12] = SSE(M(MOVLPS), M(MOVLPD), M(MOVSLDUP), M(MOVDDUP), I_NONE),
+    [0x13] = SSEF(M(MOVLPS), M(MOVLPD), NA, NA, F_MEM, I_NONE),
+    [0x14] = SSE(M(UNPCKLPS), M(UNPCKLPD), NA, NA, I_NONE),
+    [0x15] = SSE(M(UNPCKHPS), M(UNPCKHPD), NA, NA, I_NONE),
+    [0x16] = SSE(M(MOVHPS), M(MOVHPD), M(MOVSHDUP), NA, I_NONE),
+    [0x17] = SSEF(M(MOVHPS), M(MOVHPD), NA, NA, F_MEM, I_NONE),
+    [0x18] = GRP(G_16, 0, I_NONE),
+    [0x19] = OP(NOP, F_MODRM, I_NONE), [0x1A] = OP(NOP, F_MODRM, I_NONE),
+    [0x1B] = OP(NOP, F_MODRM, I_NONE), [0x1C] = OP(NOP, F_MODRM, I_NONE),
+    [0x1D] = OP(NOP, F_MODRM, I_NONE), [0x1E] = OP(NOP, F_MODRM, I_NONE),
+    [0x1F] = OP(NOP, F_MODRM, I_NONE),
+    [0x20] = OP(MOV, F_MODRM | F_MODREG, I_NONE), [0x21] = OP(MOV, F_MODRM | F_MODREG, I_NONE),
+    [0x22] = OP(MOV, F_MODRM | F_MODREG, I_NONE), [0x23] = OP(MOV, F_MODRM | F_MODREG, I_NONE),
+    [0x24] = OP(MOV, F_MODRM | F_MODREG | F_INV64, I_NONE),
+    [0x26] = OP(MOV, F_MODRM | F_MODREG | F_INV64, I_NONE),
+    [0x28] = SSE(M(MOVAPS), M(MOVAPD), NA, NA, I_NONE),
+    [0x29] = SSE(M(MOVAPS), M(MOVAPD), NA, NA, I_NONE),
+    [0x2A] = SSE(M(CVTPI2PS), M(CVTPI2PD), M(CVTSI2SS), M(CVTSI2SD), I_NONE),
+    [0x2B] = SSEF(M(MOVNTPS), M(MOVNTPD), UNK, UNK, F_MEM, I_NONE),     // MOVNTSS, MOVNTSD
+    [0x2C] = SSE(M(CVTTPS2PI), M(CVTTPD2PI), M(CVTTSS2SI), M(CVTTSD2SI), I_NONE),
+    [0x2D] = SSE(M(CVTPS2PI), M(CVTPD2PI), M(CVTSS2SI), M(CVTSD2SI), I_NONE),
+    [0x2E] = SSE(M(UCOMISS), M(UCOMISD), NA, NA, I_NONE),
+    [0x2F] = SSE(M(COMISS), M(COMISD), NA, NA, I_NONE),
+    [0x30] = OP(WRMSR, 0, I_NONE), [0x31] = OP(RDTSC, 0, I_NONE),
+    [0x32] = OP(RDMSR, 0, I_NONE), [0x33] = OP(RDPMC, 0, I_NONE),
+    [0x34] = OP(SYSENTER, 0, I_NONE), [0x35] = OP(SYSEXIT, 0, I_NONE),
+    [0x37] = OP(GETSEC, 0, I_NONE),
+    [0x40] = OP(CMOVO, F_MODRM, I_NONE), [0x41] = OP(CMOVNO, F_MODRM, I_NONE),
+    [0x42] = OP(CMOVB, F_MODRM, I_NONE), [0x43] = OP(CMOVAE, F_MODRM, I_NONE),
+    [0x44] = OP(CMOVE, F_MODRM, I_NONE), [0x45] = OP(CMOVNE, F_MODRM, I_NONE),
+    [0x46] = OP(CMOVBE, F_MODRM, I_NONE), [0x47] = OP(CMOVA, F_MODRM, I_NONE),
+    [0x48] = OP(CMOVS, F_MODRM, I_NONE), [0x49] = OP(CMOVNS, F_MODRM, I_NONE),
+    [0x4A] = OP(CMOVP, F_MODRM, I_NONE), [0x4B] = OP(CMOVNP, F_MODRM, I_NONE),
+    [0x4C] = OP(CMOVL, F_MODRM, I_NONE), [0x4D] = OP(CMOVGE, F_MODRM, I_NONE),
+    [0x4E] = OP(CMOVLE, F_MODRM, I_NONE), [0x4F] = OP(CMOVG, F_MODRM, I_NONE),
+    [0x50] = SSEF(M(MOVMSKPS), M(MOVMSKPD), NA, NA, F_NOMEM, I_NONE),
+    [0x51] = SSE(M(SQRTPS), M(SQRTPD), M(SQRTSS), M(SQRTSD), I_NONE),
+    [0x52] = SSE(M(RSQRTPS), NA, M(RSQRTSS), NA, I_NONE),
+    [0x53] = SSE(M(RCPPS), NA, M(RCPSS), NA, I_NONE),
+    [0x54] = SSE(M(ANDPS), M(ANDPD), NA, NA, I_NONE),
+    [0x55] = SSE(M(ANDNPS), M(ANDNPD), NA, NA, I_NONE),
+    [0x56] = SSE(M(ORPS), M(ORPD), NA, NA, I_NONE),
+    [0x57] = SSE(M(XORPS), M(XORPD), NA, NA, I_NONE),
+    [0x58] = SSE(M(ADDPS), M(ADDPD), M(ADDSS), M(ADDSD), I_NONE),
+    [0x59] = SSE(M(MULPS), M(MULPD), M(MULSS), M(MULSD), I_NONE),
+    [0x5A] = SSE(M(CVTPS2PD), M(CVTPD2PS), M(CVTSS2SD), M(CVTSD2SS), I_NONE),
+    [0x5B] = SSE(M(CVTDQ2PS), M(CVTPS2DQ), M(CVTTPS2DQ), NA, I_NONE),
+    [0x5C] = SSE(M(SUBPS), M(SUBPD), M(SUBSS), M(SUBSD), I_NONE),
+    [0x5D] = SSE(M(MINPS), M(MINPD), M(MINSS), M(MINSD), I_NONE),
+    [0x5E] = SSE(M(DIVPS), M(DIVPD), M(DIVSS), M(DIVSD), I_NONE),
+    [0x5F] = SSE(M(MAXPS), M(MAXPD), M(MAXSS), M(MAXSD), I_NONE),
+    [0x60] = MMX(PUNPCKLBW, I_NONE), [0x61] = MMX(PUNPCKLWD, I_NONE),
+    [0x62] = MMX(PUNPCKLDQ, I_NONE), [0x63] = MMX(PACKSSWB, I_NONE),
+    [0x64] = MMX(PCMPGTB, I_NONE), [0x65] = MMX(PCMPGTW, I_NONE),
+    [0x66] = MMX(PCMPGTD, I_NONE), [0x67] = MMX(PACKUSWB, I_NONE),
+    [0x68] = MMX(PUNPCKHBW, I_NONE), [0x69] = MMX(PUNPCKHWD, I_NONE),
+    [0x6A] = MMX(PUNPCKHDQ, I_NONE), [0x6B] = MMX(PACKSSDW, I_NONE),
+    [0x6C] = SSE(NA, M(PUNPCKLQDQ), NA, NA, I_NONE),
+    [0x6D] = SSE(NA, M(PUNPCKHQDQ), NA, NA, I_NONE),
+    [0x6E] = SSE(M(MOVD), M(MOVD), NA, NA, I_NONE),
+    [0x6F] = SSE(M(MOVQ), M(MOVDQA), M(MOVDQU), NA, I_NONE),
+    [0x70] = SSE(M(PSHUFW), M(PSHUFD), M(PSHUFHW), M(PSHUFLW), I_B),
+    [0x71] = GRP(G_12, 0, I_B), [0x72] = GRP(G_13, 0, I_B),
+    [0x73] = GRP(G_14, 0, I_B),
+    [0x74] = MMX(PCMPEQB, I_NONE), [0x75] = MMX(PCMPEQW, I_NONE),
+    [0x76] = MMX(PCMPEQD, I_NONE), [0x77] = SSE0(M(EMMS), NA, NA, NA),
+    [0x78] = SSE(M(VMREAD), UNK, NA, UNK, I_NONE),
+    [0x79] = SSE(M(VMWRITE), UNK, NA, UNK, I_NONE),
+    [0x7C] = SSE(NA, M(HADDPD), NA, M(HADDPS), I_NONE),
+    [0x7D] = SSE(NA, M(HSUBPD), NA, M(HSUBPS), I_NONE),
+    [0x7E] = SSE(M(MOVD), M(MOVD), M(MOVQ), NA, I_NONE),
+    [0x7F] = SSE(M(MOVQ), M(MOVDQA), M(MOVDQU), NA, I_NONE),
+    [0x80] = OP(JO, 0, I_JZ), [0x81] = OP(JNO, 0, I_JZ),
+    [0x82] = OP(JB, 0, I_JZ), [0x83] = OP(JAE, 0, I_JZ),
+    [0x84] = OP(JE, 0, I_JZ), [0x85] = OP(JNE, 0, I_JZ),
+    [0x86] = OP(JBE, 0, I_JZ), [0x87] = OP(JA, 0, I_JZ),
+    [0x88] = OP(JS, 0, I_JZ), [0x89] = OP(JNS, 0, I_JZ),
+    [0x8A] = OP(JP, 0, I_JZ), [0x8B] = OP(JNP, 0, I_JZ),
+    [0x8C] = OP(JL, 0, I_JZ), [0x8D] = OP(JGE, 0, I_JZ),
+    [0x8E] = OP(JLE, 0, I_JZ), [0x8F] = OP(JG, 0, I_JZ),
+    [0x90] = OP(SETO, F_MODRM, I_NONE), [0x91] = OP(SETNO, F_MODRM, I_NONE),
+    [0x92] = OP(SETB, F_MODRM, I_NONE), [0x93] = OP(SETAE, F_MODRM, I_NONE),
+    [0x94] = OP(SETE, F_MODRM, I_NONE), [0x95] = OP(SETNE, F_MODRM, I_NONE),
+    [0x96] = OP(SETBE, F_MODRM, I_NONE), [0x97] = OP(SETA, F_MODRM, I_NONE),
+    [0x98] = OP(SETS, F_MODRM, I_NONE), [0x99] = OP(SETNS, F_MODRM, I_NONE),
+    [0x9A] = OP(SETP, F_MODRM, I_NONE), [0x9B] = OP(SETNP, F_MODRM, I_NONE),
+    [0x9C] = OP(SETL, F_MODRM, I_NONE), [0x9D] = OP(SETGE, F_MODRM, I_NONE),
+    [0x9E] = OP(SETLE, F_MODRM, I_NONE), [0x9F] = OP(SETG, F_MODRM, I_NONE),
+    [0xA0] = OP(PUSH, F_W16, I_NONE), [0xA1] = OP(POP, F_W16, I_NONE),
+    [0xA2] = OP(CPUID, 0, I_NONE), [0xA3] = OP(BT, F_MODRM, I_NONE),
+    [0xA4] = OP(SHLD, F_MODRM, I_B), [0xA5] = OP(SHLD, F_MODRM, I_NONE),
+    [0xA6] = OPU(F_MODRM | F_REGOP, I_NONE), [0xA7] = OPU(F_MODRM | F_REGOP, I_NONE),
+    [0xA8] = OP(PUSH, F_W16, I_NONE), [0xA9] = OP(POP, F_W16, I_NONE),
+    [0xAA] = OP(RSM, 0, I_NONE), [0xAB] = OP(BTS, F_MODRM, I_NONE),
+    [0xAC] = OP(SHRD, F_MODRM, I_B), [0xAD] = OP(SHRD, F_MODRM, I_NONE),
+    [0xAE] = GRP(G_15, 0, I_NONE), [0xAF] = OP(IMUL, F_MODRM, I_NONE),
+    [0xB0] = OP(CMPXCHG, F_MODRM, I_NONE), [0xB1] = OP(CMPXCHG, F_MODRM, I_NONE),
+    [0xB2] = OP(LSS, F_MODRM | F_MEM, I_NONE), [0xB3] = OP(BTR, F_MODRM, I_NONE),
+    [0xB4] = OP(LFS, F_MODRM | F_MEM, I_NONE), [0xB5] = OP(LGS, F_MODRM | F_MEM, I_NONE),
+    [0xB6] = OP(MOVZX, F_MODRM, I_NONE), [0xB7] = OP(MOVZX, F_MODRM, I_NONE),
+    [0xB8] = SSE(NA, NA, M(POPCNT), NA, I_NONE),
+    [0xB9] = OP(UD1, F_MODRM, I_NONE), [0xBA] = GRP(G_8, 0, I_NONE),
+    [0xBB] = OP(BTC, F_MODRM, I_NONE),
+    [0xBC] = SSE(M(BSF), M(BSF), M(TZCNT), NA, I_NONE),
+    [0xBD] = SSE(M(BSR), M(BSR), M(LZCNT), NA, I_NONE),
+    [0xBE] = OP(MOVSX, F_MODRM, I_NONE), [0xBF] = OP(MOVSX, F_MODRM, I_NONE),
+    [0xC0] = OP(XADD, F_MODRM, I_NONE), [0xC1] = OP(XADD, F_MODRM, I_NONE),
+    [0xC2] = SSE(M(CMPPS), M(CMPPD), M(CMPSS), M(CMPSD), I_B),
+    [0xC3] = SSEF(M(MOVNTI), NA, NA, NA, F_MEM, I_NONE),
+    [0xC4] = MMX(PINSRW, I_B), [0xC5] = SSEF(M(PEXTRW), M(PEXTRW), NA, NA, F_NOMEM, I_B),
+    [0xC6] = SSE(M(SHUFPS), M(SHUFPD), NA, NA, I_B),
+    [0xC7] = GRP(G_9, 0, I_NONE),
+    [0xC8] = OP(BSWAP, 0, I_NONE), [0xC9] = OP(BSWAP, 0, I_NONE),
+    [0xCA] = OP(BSWAP, 0, I_NONE), [0xCB] = OP(BSWAP, 0, I_NONE),
+    [0xCC] = OP(BSWAP, 0, I_NONE), [0xCD] = OP(BSWAP, 0, I_NONE),
+    [0xCE] = OP(BSWAP, 0, I_NONE), [0xCF] = OP(BSWAP, 0, I_NONE),
+    [0xD0] = SSE(NA, M(ADDSUBPD), NA, M(ADDSUBPS), I_NONE),
+    [0xD1] = MMX(PSRLW, I_NONE), [0xD2] = MMX(PSRLD, I_NONE),
+    [0xD3] = MMX(PSRLQ, I_NONE), [0xD4] = MMX(PADDQ, I_NONE),
+    [0xD5] = MMX(PMULLW, I_NONE),
+    [0xD6] = SSE(NA, M(MOVQ), M(MOVQ2DQ), M(MOVDQ2Q), I_NONE),
+    [0xD7] = SSEF(M(PMOVMSKB), M(PMOVMSKB), M(PMOVMSKB), M(PMOVMSKB), F_NOMEM, I_NONE),
+    [0xD8] = MMX(PSUBUSB, I_NONE), [0xD9] = MMX(PSUBUSW, I_NONE),
+    [0xDA] = MMX(PMINUB, I_NONE), [0xDB] = MMX(PAND, I_NONE),
+    [0xDC] = MMX(PADDUSB, I_NONE), [0xDD] = MMX(PADDUSW, I_NONE),
+    [0xDE] = MMX(PMAXUB, I_NONE), [0xDF] = MMX(PANDN, I_NONE),
+    [0xE0] = MMX(PAVGB, I_NONE), [0xE1] = MMX(PSRAW, I_NONE),
+    [0xE2] = MMX(PSRAD, I_NONE), [0xE3] = MMX(PAVGW, I_NONE),
+    [0xE4] = MMX(PMULHUW, I_NONE), [0xE5] = MMX(PMULHW, I_NONE),
+    [0xE6] = SSE(NA, M(CVTTPD2DQ), M(CVTDQ2PD), M(CVTPD2DQ), I_NONE),
+    [0xE7] = SSEF(M(MOVNTQ), M(MOVNTDQ), NA, NA, F_MEM, I_NONE),
+    [0xE8] = MMX(PSUBSB, I_NONE), [0xE9] = MMX(PSUBSW, I_NONE),
+    [0xEA] = MMX(PMINSW, I_NONE), [0xEB] = MMX(POR, I_NONE),
+    [0xEC] = MMX(PADDSB, I_NONE), [0xED] = MMX(PADDSW, I_NONE),
+    [0xEE] = MMX(PMAXSW, I_NONE), [0xEF] = MMX(PXOR, I_NONE),
+    [0xF0] = SSEF(NA, NA, NA, M(LDDQU), F_MEM, I_NONE),
+    [0xF1] = MMX(PSLLW, I_NONE), [0xF2] = MMX(PSLLD, I_NONE),
+    [0xF3] = MMX(PSLLQ, I_NONE), [0xF4] = MMX(PMULUDQ, I_NONE),
+    [0xF5] = MMX(PMADDWD, I_NONE), [0xF6] = MMX(PSADBW, I_NONE),
+    [0xF7] = SSEF(M(MASKMOVQ), M(MASKMOVDQU), NA, NA, F_REGOP, I_NONE),
+    [0xF8] = MMX(PSUBB, I_NONE), [0xF9] = MMX(PSUBW, I_NONE),
+    [0xFA] = MMX(PSUBD, I_NONE), [0xFB] = MMX(PSUBQ, I_NONE),
+    [0xFC] = MMX(PADDB, I_NONE), [0xFD] = MMX(PADDW, I_NONE),
+    [0xFE] = MMX(PADDD, I_NONE), [0xFF] = OP(UD0, F_MODRM, I_NONE),
+};
+
+// Every 0F38 instruction has a ModRM byte and no immediate
+static const OpInfo map_0f38[256] = {
+    [0x00] = SSE(M(PSHUFB), M(PSHUFB), NA, NA, I_NONE),
+    [0x01] = SSE(M(PHADDW), M(PHADDW), NA, NA, I_NONE),
+    [0x02] = SSE(M(PHADDD), M(PHADDD), NA, NA, I_NONE),
+    [0x03] = SSE(M(PHADDSW), M(PHADDSW), NA, NA, I_NONE),
+    [0x04] = SSE(M(PMADDUBSW), M(PMADDUBSW), NA, NA, I_NONE),
+    [0x05] = SSE(M(PHSUBW), M(PHSUBW), NA, NA, I_NONE),
+    [0x06] = SSE(M(PHSUBD), M(PHSUBD), NA, NA, I_NONE),
+    [0x07] = SSE(M(PHSUBSW), M(PHSUBSW), NA, NA, I_NONE),
+    [0x08] = SSE(M(PSIGNB), M(PSIGNB), NA, NA, I_NONE),
+    [0x09] = SSE(M(PSIGNW), M(PSIGNW), NA, NA, I_NONE),
+    [0x0A] = SSE(M(PSIGND), M(PSIGND), NA, NA, I_NONE),
+    [0x0B] = SSE(M(PMULHRSW), M(PMULHRSW), NA, NA, I_NONE),
+    [0x10] = SSE(NA, M(PBLENDVB), NA, NA, I_NONE),
+    [0x14] = SSE(NA, M(BLENDVPS), NA, NA, I_NONE),
+    [0x15] = SSE(NA, M(BLENDVPD), NA, NA, I_NONE),
+    [0x17] = SSE(NA, M(PTEST), NA, NA, I_NONE),
+    [0x1C] = SSE(M(PABSB), M(PABSB), NA, NA, I_NONE),
+    [0x1D] = SSE(M(PABSW), M(PABSW), NA, NA, I_NONE),
+    [0x1E] = SSE(M(PABSD), M(PABSD), NA, NA, I_NONE),
+    [0x20] = SSE(NA, M(PMOVSXBW), NA, NA, I_NONE),
+    [0x21] = SSE(NA, M(PMOVSXBD), NA, NA, I_NONE),
+    [0x22] = SSE(NA, M(PMOVSXBQ), NA, NA, I_NONE),
+    [0x23] = SSE(NA, M(PMOVSXWD), NA, NA, I_NONE),
+    [0x24] = SSE(NA, M(PMOVSXWQ), NA, NA, I_NONE),
+    [0x25] = SSE(NA, M(PMOVSXDQ), NA, NA, I_NONE),
+    [0x28] = SSE(NA, M(PMULDQ), NA, NA, I_NONE),
+    [0x29] = SSE(NA, M(PCMPEQQ), NA, NA, I_NONE),
+    [0x2A] = SSEF(NA, M(MOVNTDQA), NA, NA, F_MEM, I_NONE),
+    [0x2B] = SSE(NA, M(PACKUSDW), NA, NA, I_NONE),
+    [0x30] = SSE(NA, M(PMOVZXBW), NA, NA, I_NONE),
+    [0x31] = SSE(NA, M(PMOVZXBD), NA, NA, I_NONE),
+    [0x32] = SSE(NA, M(PMOVZXBQ), NA, NA, I_NONE),
+    [0x33] = SSE(NA, M(PMOVZXWD), NA, NA, I_NONE),
+    [0x34] = SSE(NA, M(PMOVZXWQ), NA, NA, I_NONE),
+    [0x35] = SSE(NA, M(PMOVZXDQ), NA, NA, I_NONE),
+    [0x37] = SSE(NA, M(PCMPGTQ), NA, NA, I_NONE),
+    [0x38] = SSE(NA, M(PMINSB), NA, NA, I_NONE),
+    [0x39] = SSE(NA, M(PMINSD), NA, NA, I_NONE),
+    [0x3A] = SSE(NA, M(PMINUW), NA, NA, I_NONE),
+    [0x3B] = SSE(NA, M(PMINUD), NA, NA, I_NONE),
+    [0x3C] = SSE(NA, M(PMAXSB), NA, NA, I_NONE),
+    [0x3D] = SSE(NA, M(PMAXSD), NA, NA, I_NONE),
+    [0x3E] = SSE(NA, M(PMAXUW), NA, NA, I_NONE),
+    [0x3F] = SSE(NA, M(PMAXUD), NA, NA, I_NONE),
+    [0x40] = SSE(NA, M(PMULLD), NA, NA, I_NONE),
+    [0x41] = SSE(NA, M(PHMINPOSUW), NA, NA, I_NONE),
+    [0x80] = SSEF(NA, M(INVEPT), NA, NA, F_MEMOP, I_NONE),
+    [0x81] = SSEF(NA, M(INVVPID), NA, NA, F_MEMOP, I_NONE),
+    [0x82] = SSEF(NA, M(INVPCID), NA, NA, F_MEMOP, I_NONE),
+    [0xC8] = SSE(M(SHA1NEXTE), NA, NA, NA, I_NONE),
+    [0xC9] = SSE(M(SHA1MSG1), NA, NA, NA, I_NONE),
+    [0xCA] = SSE(M(SHA1MSG2), NA, NA, NA, I_NONE),
+    [0xCB] = SSE(M(SHA256RNDS2), NA, NA, NA, I_NONE),
+    [0xCC] = SSE(M(SHA256MSG1), NA, NA, NA, I_NONE),
+    [0xCD] = SSE(M(SHA256MSG2), NA, NA, NA, I_NONE),
+    [0xCF] = SSE(NA, UNK, NA, NA, I_NONE),                  // GF2P8MULB
+    // F3: Key Locker (AESENC128KL, LOADIWKEY, ...)
+    [0xD8] = SSEF(NA, NA, UNK, NA, F_MEMOP, I_NONE),
+    [0xDB] = SSE(NA, M(AESIMC), NA, NA, I_NONE),
+    [0xDC] = SSE(NA, M(AESENC), UNK, NA, I_NONE),
+    [0xDD] = SSE(NA, M(AESENCLAST), UNK, NA, I_NONE),
+    [0xDE] = SSE(NA, M(AESDEC), UNK, NA, I_NONE),
+    [0xDF] = SSE(NA, M(AESDECLAST), UNK, NA, I_NONE),
+    [0xF0] = SSE(M(MOVBE), M(MOVBE), NA, M(CRC32), I_NONE),
+    [0xF1] = SSE(M(MOVBE), M(MOVBE), NA, M(CRC32), I_NONE),
+    // Memory-only: WRUSS; WRSS; MOVDIR64B, ENQCMDS, ENQCMD; MOVDIRI
+    [0xF5] = SSEF(NA, UNK, NA, NA, F_MEM, I_NONE),
+    [0xF6] = SSE(UNK, M(ADCX), M(ADOX), NA, I_NONE),
+    [0xF8] = SSEF(NA, UNK, UNK, UNK, F_MEM, I_NONE),
+    [0xF9] = SSEF(UNK, NA, NA, NA, F_MEM, I_NONE),
+    [0xFA] = SSEF(NA, NA, UNK, NA, F_NOMEM, I_NONE),        // ENCODEKEY128
+    [0xFB] = SSEF(NA, NA, UNK, NA, F_NOMEM, I_NONE),        // ENCODEKEY256
+    [0xFC] = SSEF(UNK, UNK, UNK, UNK, F_MEMOP, I_NONE),     // AADD, AAND, AXOR, AOR
+};
+
+// Every 0F3A instruction has a ModRM byte and an imm8
+static const OpInfo map_0f3a[256] = {
+    [0x08] = SSE(NA, M(ROUNDPS), NA, NA, I_B),
+    [0x09] = SSE(NA, M(ROUNDPD), NA, NA, I_B),
+    [0x0A] = SSE(NA, M(ROUNDSS), NA, NA, I_B),
+    [0x0B] = SSE(NA, M(ROUNDSD), NA, NA, I_B),
+    [0x0C] = SSE(NA, M(BLENDPS), NA, NA, I_B),
+    [0x0D] = SSE(NA, M(BLENDPD), NA, NA, I_B),
+    [0x0E] = SSE(NA, M(PBLENDW), NA, NA, I_B),
+    [0x0F] = SSE(M(PALIGNR), M(PALIGNR), NA, NA, I_B),
+    [0x14] = SSE(NA, M(PEXTRB), NA, NA, I_B),
+    [0x15] = SSE(NA, M(PEXTRW), NA, NA, I_B),
+    [0x16] = SSE(NA, M(PEXTRD), NA, NA, I_B),
+    [0x17] = SSE(NA, M(EXTRACTPS), NA, NA, I_B),
+    [0x20] = SSE(NA, M(PINSRB), NA, NA, I_B),
+    [0x21] = SSE(NA, M(INSERTPS), NA, NA, I_B),
+    [0x22] = SSE(NA, M(PINSRD), NA, NA, I_B),
+    [0x40] = SSE(NA, M(DPPS), NA, NA, I_B),
+    [0x41] = SSE(NA, M(DPPD), NA, NA, I_B),
+    [0x42] = SSE(NA, M(MPSADBW), NA, NA, I_B),
+    [0x44] = SSE(NA, M(PCLMULQDQ), NA, NA, I_B),
+    [0x60] = SSE(NA, M(PCMPESTRM), NA, NA, I_B),
+    [0x61] = SSE(NA, M(PCMPESTRI), NA, NA, I_B),
+    [0x62] = SSE(NA, M(PCMPISTRM), NA, NA, I_B),
+    [0x63] = SSE(NA, M(PCMPISTRI), NA, NA, I_B),
+    [0xCC] = SSE(M(SHA1RNDS4), NA, NA, NA, I_B),
+    [0xCE] = SSE(NA, UNK, NA, NA, I_B),                     // GF2P8AFFINEQB
+    [0xCF] = SSE(NA, UNK, NA, NA, I_B),                     // GF2P8AFFINEINVQB
+    [0xDF] = SSE(NA, M(AESKEYGENASSIST), NA, NA, I_B),
+};
+
+// x87 (D8-DF). Memory forms are named by [opcode & 7][reg]; register
+// forms by [opcode & 7][reg] too, except where FP_RM marks a row whose
+// entries differ per rm and are listed in x87_rm below. The DC and DE
+// register rows keep objdump's historical fsub/fsubr and fdiv/fdivr swap,
+// and the undocumented aliases it spells fcom2, fxch4, fstp8, ... are UNK.
+#define FP_RM   (-3)
+
+static const int16_t x87_mem[8][8] = {
+    { M(FADD), M(FMUL), M(FCOM), M(FCOMP), M(FSUB), M(FSUBR), M(FDIV), M(FDIVR) },
+    { M(FLD), NA, M(FST), M(FSTP), M(FLDENV), M(FLDCW), M(FNSTENV), M(FNSTCW) },
+    { M(FIADD), M(FIMUL), M(FICOM), M(FICOMP), M(FISUB), M(FISUBR), M(FIDIV), M(FIDIVR) },
+    { M(FILD), M(FISTTP), M(FIST), M(FISTP), NA, M(FLD), NA, M(FSTP) },
+    { M(FADD), M(FMUL), M(FCOM), M(FCOMP), M(FSUB), M(FSUBR), M(FDIV), M(FDIVR) },
+    { M(FLD), M(FISTTP), M(FST), M(FSTP), M(FRSTOR), NA, M(FNSAVE), M(FNSTSW) },
+    { M(FIADD), M(FIMUL), M(FICOM), M(FICOMP), M(FISUB), M(FISUBR), M(FIDIV), M(FIDIVR) },
+    { M(FILD), M(FISTTP), M(FIST), M(FISTP), M(FBLD), M(FILD), M(FBSTP), M(FISTP) },
+};
+
+static const int16_t x87_reg[8][8] = {
+    { M(FADD), M(FMUL), M(FCOM), M(FCOMP), M(FSUB), M(FSUBR), M(FDIV), M(FDIVR) },
+    { M(FLD), M(FXCH), FP_RM, NA, FP_RM, FP_RM, FP_RM, FP_RM },
+    { M(FCMOVB), M(FCMOVE), M(FCMOVBE), M(FCMOVU), NA, FP_RM, NA, NA },
+    { M(FCMOVNB), M(FCMOVNE), M(FCMOVNBE), M(FCMOVNU), FP_RM, M(FUCOMI), M(FCOMI), NA },
+    { M(FADD), M(FMUL), UNK, UNK, M(FSUBR), M(FSUB), M(FDIVR), M(FDIV) },
+    { M(FFREE), UNK, M(FST), M(FSTP), M(FUCOM), M(FUCOMP), NA, NA },
+    { M(FADDP), M(FMULP), UNK, FP_RM, M(FSUBRP), M(FSUBP), M(FDIVRP), M(FDIVP) },
+    { UNK, UNK, UNK, UNK, FP_RM, M(FUCOMIP), M(FCOMIP), NA },
+};
+
+// Register forms that differ per rm, keyed by the full ModRM byte
+static int16_t x87_rm(uint8_t esc, uint8_t modrm) {
+    static const int16_t d9_e0[32] = {
+        M(FCHS), M(FABS), NA, NA, M(FTST), M(FXAM), NA, NA,
+        M(FLD1), M(FLDL2T), M(FLDL2E), M(FLDPI), M(FLDLG2), M(FLDLN2), M(FLDZ), NA,
+        M(F2XM1), M(FYL2X), M(FPTAN), M(FPATAN), M(FXTRACT), M(FPREM1), M(FDECSTP), M(FINCSTP),
+        M(FPREM), M(FYL2XP1), M(FSQRT), M(FSINCOS), M(FRNDINT), M(FSCALE), M(FSIN), M(FCOS),
+    };
+
+    switch (esc) {
+    case 1:
+        if (modrm == 0xD0) {
+            return M(FNOP);
+        }
+        return modrm >= 0xE0 ? d9_e0[modrm - 0xE0] : NA;
+    case 2:
+        return modrm == 0xE9 ? M(FUCOMPP) : NA;
+    case 3:
+        if (modrm == 0xE2) {
+            return M(FNCLEX);
+        }
+        if (modrm == 0xE3) {
+            return M(FNINIT);
+        }
+        return modrm <= 0xE4 ? UNK : NA;    // feni/fdisi/fsetpm
+    case 6:
+        return modrm == 0xD9 ? M(FCOMPP) : NA;
+    case 7:
+        return modrm == 0xE0 ? M(FNSTSW) : NA;
+    }
+    return NA;
+}
+
+// VEX- and EVEX-only instructions, and those whose name there is not
+// just "V" + the legacy name. w is VEX.W/EVEX.W, or -1 for either.
+typedef struct {
+    uint8_t map;        // 1: 0F, 2: 0F38, 3: 0F3A
+    uint8_t pp;
+    uint8_t op;
+    int8_t w;
+    int16_t mn;
+} VexOp;
+
+static const VexOp vex_ops[] = {
+    { 2, P_66, 0x18, -1, M(VBROADCASTSS) },   { 2, P_66, 0x19, -1, M(VBROADCASTSD) },
+    { 2, P_66, 0x1A, -1, M(VBROADCASTF128) }, { 2, P_66, 0x5A, -1, M(VBROADCASTI128) },
+    { 2, P_66, 0x78, -1, M(VPBROADCASTB) },   { 2, P_66, 0x79, -1, M(VPBROADCASTW) },
+    { 2, P_66, 0x58, -1, M(VPBROADCASTD) },   { 2, P_66, 0x59, -1, M(VPBROADCASTQ) },
+    { 2, P_66, 0x0C, -1, M(VPERMILPS) },      { 2, P_66, 0x0D, -1, M(VPERMILPD) },
+    { 2, P_66, 0x0E, -1, M(VTESTPS) },        { 2, P_66, 0x0F, -1, M(VTESTPD) },
+    { 2, P_66, 0x16, -1, M(VPERMPS) },        { 2, P_66, 0x36, -1, M(VPERMD) },
+    { 2, P_66, 0x2C, -1, M(VMASKMOVPS) },     { 2, P_66, 0x2D, -1, M(VMASKMOVPD) },
+    { 2, P_66, 0x2E, -1, M(VMASKMOVPS) },     { 2, P_66, 0x2F, -1, M(VMASKMOVPD) },
+    { 2, P_66, 0x8C, 0, M(VPMASKMOVD) },      { 2, P_66, 0x8C, 1, M(VPMASKMOVQ) },
+    { 2, P_66, 0x8E, 0, M(VPMASKMOVD) },      { 2, P_66, 0x8E, 1, M(VPMASKMOVQ) },
+    { 2, P_66, 0x45, 0, M(VPSRLVD) },         { 2, P_66, 0x45, 1, M(VPSRLVQ) },
+    { 2, P_66, 0x46, 0, M(VPSRAVD) },         { 2, P_66, 0x46, 1, UNK },
+    { 2, P_66, 0x47, 0, M(VPSLLVD) },         { 2, P_66, 0x47, 1, M(VPSLLVQ) },
+    { 2, P_66, 0x90, 0, M(VPGATHERDD) },      { 2, P_66, 0x90, 1, M(VPGATHERDQ) },
+    { 2, P_66, 0x91, 0, M(VPGATHERQD) },      { 2, P_66, 0x91, 1, M(VPGATHERQQ) },
+    { 2, P_66, 0x92, 0, M(VGATHERDPS) },      { 2, P_66, 0x92, 1, M(VGATHERDPD) },
+    { 2, P_66, 0x93, 0, M(VGATHERQPS) },      { 2, P_66, 0x93, 1, M(VGATHERQPD) },
+    { 2, P_66, 0x13, -1, M(VCVTPH2PS) },
+    { 3, P_66, 0x04, -1, M(VPERMILPS) },      { 3, P_66, 0x05, -1, M(VPERMILPD) },
+    { 3, P_66, 0x06, -1, M(VPERM2F128) },     { 3, P_66, 0x46, -1, M(VPERM2I128) },
+    { 3, P_66, 0x18, -1, M(VINSERTF128) },    { 3, P_66, 0x19, -1, M(VEXTRACTF128) },
+    { 3, P_66, 0x38, -1, M(VINSERTI128) },    { 3, P_66, 0x39, -1, M(VEXTRACTI128) },
+    { 3, P_66, 0x00, -1, M(VPERMQ) },         { 3, P_66, 0x01, -1, M(VPERMPD) },
+    { 3, P_66, 0x02, -1, M(VPBLENDD) },       { 3, P_66, 0x1D, -1, M(VCVTPS2PH) },
+    { 3, P_66, 0x4A, -1, M(VBLENDVPS) },      { 3, P_66, 0x4B, -1, M(VBLENDVPD) },
+    { 3, P_66, 0x4C, -1, M(VPBLENDVB) },
+    { 3, P_66, 0x16, 0, M(VPEXTRD) },         { 3, P_66, 0x16, 1, M(VPEXTRQ) },
+    { 3, P_66, 0x22, 0, M(VPINSRD) },         { 3, P_66, 0x22, 1, M(VPINSRQ) },
+
+    // BMI1/BMI2
+    { 2, P_NONE, 0xF2, -1, M(ANDN) },
+    { 2, P_NONE, 0xF5, -1, M(BZHI) },         { 2, P_F3, 0xF5, -1, M(PEXT) },
+    { 2, P_F2, 0xF5, -1, M(PDEP) },           { 2, P_F2, 0xF6, -1, M(MULX) },
+    { 2, P_NONE, 0xF7, -1, M(BEXTR) },        { 2, P_66, 0xF7, -1, M(SHLX) },
+    { 2, P_F3, 0xF7, -1, M(SARX) },           { 2, P_F2, 0xF7, -1, M(SHRX) },
+    { 3, P_F2, 0xF0, -1, M(RORX) },
+
+    // AVX-512 opmask instructions (VEX-encoded)
+    { 1, P_NONE, 0x90, 0, M(KMOVW) },         { 1, P_NONE, 0x90, 1, M(KMOVQ) },
+    { 1, P_66, 0x90, 0, M(KMOVB) },           { 1, P_66, 0x90, 1, M(KMOVD) },
+    { 1, P_NONE, 0x91, 0, M(KMOVW) },         { 1, P_NONE, 0x91, 1, M(KMOVQ) },
+    { 1, P_66, 0x91, 0, M(KMOVB) },           { 1, P_66, 0x91, 1, M(KMOVD) },
+    { 1, P_NONE, 0x92, 0, M(KMOVW) },         { 1, P_66, 0x92, 0, M(KMOVB) },
+    { 1, P_F2, 0x92, 0, M(KMOVD) },           { 1, P_F2, 0x92, 1, M(KMOVQ) },
+    { 1, P_NONE, 0x93, 0, M(KMOVW) },         { 1, P_66, 0x93, 0, M(KMOVB) },
+    { 1, P_F2, 0x93, 0, M(KMOVD) },           { 1, P_F2, 0x93, 1, M(KMOVQ) },
+    { 1, P_NONE, 0x41, 0, M(KANDW) },         { 1, P_NONE, 0x41, 1, M(KANDQ) },
+    { 1, P_66, 0x41, 0, M(KANDB) },           { 1, P_66, 0x41, 1, M(KANDD) },
+    { 1, P_NONE, 0x44, 0, M(KNOTW) },         { 1, P_NONE, 0x44, 1, M(KNOTQ) },
+    { 1, P_66, 0x44, 0, M(KNOTB) },           { 1, P_66, 0x44, 1, M(KNOTD) },
+    { 1, P_NONE, 0x45, 0, M(KORW) },          { 1, P_NONE, 0x45, 1, M(KORQ) },
+    { 1, P_66, 0x45, 0, M(KORB) },            { 1, P_66, 0x45, 1, M(KORD) },
+    { 1, P_NONE, 0x47, 0, M(KXORW) },         { 1, P_NONE, 0x47, 1, M(KXORQ) },
+    { 1, P_66, 0x47, 0, M(KXORB) },           { 1, P_66, 0x47, 1, M(KXORD) },
+    { 1, P_NONE, 0x98, 0, M(KORTESTW) },      { 1, P_NONE, 0x98, 1, M(KORTESTQ) },
+    { 1, P_66, 0x98, 0, M(KORTESTB) },        { 1, P_66, 0x98, 1, M(KORTESTD) },
+    { 1, P_66, 0x4B, 0, M(KUNPCKBW) },        { 1, P_NONE, 0x4B, -1, UNK },
+    { 1, P_NONE, 0x42, -1, UNK },             { 1, P_66, 0x42, -1, UNK },
+    { 1, P_NONE, 0x46, -1, UNK },             { 1, P_66, 0x46, -1, UNK },
+    { 1, P_NONE, 0x4A, -1, UNK },             { 1, P_66, 0x4A, -1, UNK },
+    { 1, P_NONE, 0x99, -1, UNK },             { 1, P_66, 0x99, -1, UNK },
+    { 3, P_66, 0x30, 0, UNK },                { 3, P_66, 0x30, 1, M(KSHIFTRW) },
+    { 3, P_66, 0x32, 0, UNK },                { 3, P_66, 0x32, 1, M(KSHIFTLW) },
+    { 3, P_66, 0x31, -1, UNK },               { 3, P_66, 0x33, -1, UNK },
+};
+
+static const VexOp evex_ops[] = {
+    { 1, P_66, 0x6F, 0, M(VMOVDQA32) },       { 1, P_66, 0x6F, 1, M(VMOVDQA64) },
+    { 1, P_66, 0x7F, 0, M(VMOVDQA32) },       { 1, P_66, 0x7F, 1, M(VMOVDQA64) },
+    { 1, P_F3, 0x6F, 0, M(VMOVDQU32) },       { 1, P_F3, 0x6F, 1, M(VMOVDQU64) },
+    { 1, P_F3, 0x7F, 0, M(VMOVDQU32) },       { 1, P_F3, 0x7F, 1, M(VMOVDQU64) },
+    { 1, P_F2, 0x6F, 0, M(VMOVDQU8) },        { 1, P_F2, 0x6F, 1, M(VMOVDQU16) },
+    { 1, P_F2, 0x7F, 0, M(VMOVDQU8) },        { 1, P_F2, 0x7F, 1, M(VMOVDQU16) },
+    { 1, P_66, 0xDB, 0, M(VPANDD) },          { 1, P_66, 0xDB, 1, M(VPANDQ) },
+    { 1, P_66, 0xDF, 0, M(VPANDND) },         { 1, P_66, 0xDF, 1, M(VPANDNQ) },
+    { 1, P_66, 0xEB, 0, M(VPORD) },           { 1, P_66, 0xEB, 1, M(VPORQ) },
+    { 1, P_66, 0xEF, 0, M(VPXORD) },          { 1, P_66, 0xEF, 1, M(VPXORQ) },
+    { 1, P_F2, 0x7A, 0, M(VCVTUDQ2PS) },      { 1, P_66, 0x7A, 1, M(VCVTTPD2QQ) },
+    { 1, P_NONE, 0x79, 0, M(VCVTPS2UDQ) },    { 1, P_NONE, 0x78, 0, M(VCVTTPS2UDQ) },
+    { 1, P_66, 0x7B, 1, M(VCVTPD2QQ) },       { 1, P_F3, 0xE6, 1, M(VCVTQQ2PD) },
+    { 2, P_66, 0x8B, 0, M(VPCOMPRESSD) },     { 2, P_66, 0x8B, 1, M(VPCOMPRESSQ) },
+    { 2, P_66, 0x89, 0, M(VPEXPANDD) },       { 2, P_66, 0x89, 1, M(VPEXPANDQ) },
+    { 2, P_66, 0x8A, 0, M(VCOMPRESSPS) },     { 2, P_66, 0x8A, 1, M(VCOMPRESSPD) },
+    { 2, P_66, 0x88, 0, M(VEXPANDPS) },       { 2, P_66, 0x88, 1, M(VEXPANDPD) },
+    { 2, P_66, 0x7E, 0, M(VPERMT2D) },        { 2, P_66, 0x7E, 1, M(VPERMT2Q) },
+    { 2, P_66, 0x7F, 0, M(VPERMT2PS) },       { 2, P_66, 0x7F, 1, M(VPERMT2PD) },
+    { 2, P_66, 0x76, 0, M(VPERMI2D) },        { 2, P_66, 0x76, 1, M(VPERMI2Q) },
+    { 2, P_66, 0x77, 0, M(VPERMI2PS) },       { 2, P_66, 0x77, 1, M(VPERMI2PD) },
+    { 2, P_66, 0x15, 0, M(VPROLVD) },         { 2, P_66, 0x15, 1, M(VPROLVQ) },
+    { 2, P_66, 0x14, 0, M(VPRORVD) },         { 2, P_66, 0x14, 1, M(VPRORVQ) },
+    { 2, P_F3, 0x31, -1, M(VPMOVDB) },        { 2, P_F3, 0x33, -1, M(VPMOVDW) },
+    { 2, P_F3, 0x32, -1, M(VPMOVQB) },        { 2, P_F3, 0x34, -1, M(VPMOVQW) },
+    { 2, P_F3, 0x35, -1, M(VPMOVQD) },        { 2, P_F3, 0x30, -1, M(VPMOVWB) },
+    { 2, P_66, 0xA0, 0, M(VPSCATTERDD) },     { 2, P_66, 0xA0, 1, M(VPSCATTERDQ) },
+    { 2, P_66, 0xA1, 0, M(VPSCATTERQD) },     { 2, P_66, 0xA1, 1, M(VPSCATTERQQ) },
+    { 2, P_66, 0xA2, 0, M(VSCATTERDPS) },     { 2, P_66, 0xA2, 1, M(VSCATTERDPD) },
+    { 2, P_66, 0xA3, 0, M(VSCATTERQPS) },     { 2, P_66, 0xA3, 1, M(VSCATTERQPD) },
+    { 2, P_66, 0x1A, 0, M(VBROADCASTF32X4) }, { 2, P_66, 0x5A, 0, M(VBROADCASTI32X4) },
+    { 2, P_66, 0x7A, 0, M(VPBROADCASTB) },    { 2, P_66, 0x7B, 0, M(VPBROADCASTW) },
+    { 2, P_66, 0x7C, 0, M(VPBROADCASTD) },    { 2, P_66, 0x7C, 1, M(VPBROADCASTQ) },
+    { 2, P_66, 0x1F, 1, M(VPABSQ) },
+    { 2, P_66, 0x3D, 1, M(VPMAXSQ) },         { 2, P_66, 0x3F, 1, M(VPMAXUQ) },
+    { 2, P_66, 0x39, 1, M(VPMINSQ) },         { 2, P_66, 0x3B, 1, M(VPMINUQ) },
+    { 2, P_66, 0x40, 1, M(VPMULLQ) },         { 2, P_66, 0x46, 1, M(VPSRAVQ) },
+    { 2, P_66, 0x4C, 0, M(VRCP14PS) },        { 2, P_66, 0x4C, 1, M(VRCP14PD) },
+    { 2, P_66, 0x4E, 0, M(VRSQRT14PS) },      { 2, P_66, 0x4E, 1, M(VRSQRT14PD) },
+    { 2, P_66, 0x42, 0, M(VGETEXPPS) },       { 2, P_66, 0x42, 1, M(VGETEXPPD) },
+    { 2, P_66, 0x2C, 0, M(VSCALEFPS) },       { 2, P_66, 0x2C, 1, M(VSCALEFPD) },
+    { 2, P_66, 0x27, 0, M(VPTESTMD) },        { 2, P_66, 0x27, 1, M(VPTESTMQ) },
+    { 2, P_F3, 0x27, 0, M(VPTESTNMD) },       { 2, P_F3, 0x27, 1, M(VPTESTNMQ) },
+    { 2, P_66, 0x26, -1, UNK },               { 2, P_F3, 0x26, -1, UNK },
+    { 2, P_F3, 0x2A, 1, M(VPBROADCASTMB2Q) }, { 2, P_F3, 0x3A, 0, M(VPBROADCASTMW2D) },
+    { 2, P_66, 0xC4, 0, M(VPCONFLICTD) },     { 2, P_66, 0xC4, 1, M(VPCONFLICTQ) },
+    { 2, P_66, 0x44, 0, M(VPLZCNTD) },        { 2, P_66, 0x44, 1, M(VPLZCNTQ) },
+    { 3, P_66, 0x25, 0, M(VPTERNLOGD) },      { 3, P_66, 0x25, 1, M(VPTERNLOGQ) },
+    { 3, P_66, 0x1F, 0, M(VPCMPD) },          { 3, P_66, 0x1F, 1, M(VPCMPQ) },
+    { 3, P_66, 0x1E, 0, M(VPCMPUD) },         { 3, P_66, 0x1E, 1, M(VPCMPUQ) },
+    { 3, P_66, 0x3F, 0, M(VPCMPB) },          { 3, P_66, 0x3F, 1, M(VPCMPW) },
+    { 3, P_66, 0x3E, 0, M(VPCMPUB) },         { 3, P_66, 0x3E, 1, M(VPCMPUW) },
+    { 3, P_66, 0x19, 0, M(VEXTRACTF32X4) },   { 3, P_66, 0x1B, 1, M(VEXTRACTF64X4) },
+    { 3, P_66, 0x39, 0, M(VEXTRACTI32X4) },   { 3, P_66, 0x3B, 1, M(VEXTRACTI64X4) },
+    { 3, P_66, 0x18, 0, M(VINSERTF32X4) },    { 3, P_66, 0x1A, 1, M(VINSERTF64X4) },
+    { 3, P_66, 0x38, 0, M(VINSERTI32X4) },    { 3, P_66, 0x3A, 1, M(VINSERTI64X4) },
+    { 3, P_66, 0x03, 0, M(VALIGND) },         { 3, P_66, 0x03, 1, M(VALIGNQ) },
+    { 3, P_66, 0x26, 0, M(VGETMANTPS) },      { 3, P_66, 0x26, 1, M(VGETMANTPD) },
+    { 3, P_66, 0x08, 0, M(VRNDSCALEPS) },     { 3, P_66, 0x09, 1, M(VRNDSCALEPD) },
+    { 3, P_66, 0x54, 0, M(VFIXUPIMMPS) },     { 3, P_66, 0x54, 1, M(VFIXUPIMMPD) },
+    { 2, P_66, 0x64, -1, UNK },               { 2, P_66, 0x65, -1, UNK },
+    { 2, P_66, 0x66, -1, UNK },
+    { 3, P_66, 0x23, -1, UNK },               { 3, P_66, 0x43, -1, UNK },
+
+    // IFMA, VBMI, VBMI2, VNNI, BITALG and VPOPCNTDQ: not in mnemonics.def
+    { 2, P_66, 0xB4, 1, UNK },                { 2, P_66, 0xB5, 1, UNK },
+    { 2, P_66, 0x8D, -1, UNK },               { 2, P_66, 0x83, 1, UNK },
+    { 2, P_66, 0x75, -1, UNK },               { 2, P_66, 0x7D, -1, UNK },
+    { 2, P_66, 0x62, -1, UNK },               { 2, P_66, 0x63, -1, UNK },
+    { 2, P_66, 0x70, 1, UNK },                { 2, P_66, 0x71, -1, UNK },
+    { 2, P_66, 0x72, 1, UNK },                { 2, P_66, 0x73, -1, UNK },
+    { 2, P_66, 0x50, 0, UNK },                { 2, P_66, 0x51, 0, UNK },
+    { 2, P_66, 0x52, 0, UNK },                { 2, P_66, 0x53, 0, UNK },
+    { 2, P_66, 0x54, -1, UNK },               { 2, P_66, 0x55, -1, UNK },
+    { 2, P_66, 0x8F, 0, UNK },
+    { 3, P_66, 0x70, 1, UNK },                { 3, P_66, 0x71, -1, UNK },
+    { 3, P_66, 0x72, 1, UNK },                { 3, P_66, 0x73, -1, UNK },
+};
+
+// Run-time tables, filled once: the VEX name of every legacy mnemonic
+// and the VEX/EVEX-only entries above, by [map - 1][pp][opcode][W]
+static int16_t vex_name[N_MNEMONICS];
+static int16_t vex_table[3][4][256][2];
+static int16_t evex_table[3][4][256][2];
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+static void fill_table(int16_t table[3][4][256][2], const VexOp *ops, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const VexOp *v = &ops[i];
+        for (int w = 0; w < 2; w++) {
+            if (v->w < 0 || v->w == w) {
+                table[v->map - 1][v->pp][v->op][w] = v->mn;
+            }
+        }
+    }
+}
+
+static void build_tables(void) {
+    for (int i = 0; i < N_MNEMONICS; i++) {
+        char name[32] = "V";
+        size_t len = strlen(mnemonic_names[i]);
+        vex_name[i] = UNK;
+        if (len + 1 < sizeof(name)) {
+            memcpy(name + 1, mnemonic_names[i], len);
+            vex_name[i] = (int16_t)mnemonic_lookup(name, len + 1);
+        }
+    }
+
+    for (int m = 0; m < 3; m++) {
+        for (int pp = 0; pp < 4; pp++) {
+            for (int op = 0; op < 256; op++) {
+                vex_table[m][pp][op][0] = vex_table[m][pp][op][1] = NA;
+                evex_table[m][pp][op][0] = evex_table[m][pp][op][1] = NA;
+            }
+        }
+    }
+    fill_table(vex_table, vex_ops, sizeof(vex_ops) / sizeof(vex_ops[0]));
+    fill_table(evex_table, vex_ops, sizeof(vex_ops) / sizeof(vex_ops[0]));
+    fill_table(evex_table, evex_ops, sizeof(evex_ops) / sizeof(evex_ops[0]));
+
+    // FMA: 0F38 96-BF; the low nibble picks the operation, the high one
+    // the operand order, and W single or double precision
+    static const char *const fma_ops[10] = {
+        "FMADDSUB", "FMSUBADD", "FMADD", "FMADD", "FMSUB", "FMSUB",
+        "FNMADD", "FNMADD", "FNMSUB", "FNMSUB",
+    };
+    static const char *const orders[3] = { "132", "213", "231" };
+    for (int hi = 0; hi < 3; hi++) {
+        for (int lo = 6; lo < 16; lo++) {
+            for (int w = 0; w < 2; w++) {
+                const char *kind = (lo >= 8 && (lo & 1)) ? (w ? "SD" : "SS") : (w ? "PD" : "PS");
+                char name[32];
+                int len = snprintf(name, sizeof(name), "V%s%s%s", fma_ops[lo - 6], orders[hi], kind);
+                int mn = mnemonic_lookup(name, (size_t)len);
+                int op = 0x90 + hi * 0x10 + lo;
+                vex_table[1][P_66][op][w] = evex_table[1][P_66][op][w] = (int16_t)(mn >= 0 ? mn : UNK);
+            }
+        }
+    }
+}
+
+// Decoder state for one instruction
+typedef struct {
+    const uint8_t *start;
+    const uint8_t *p;
+    const uint8_t *end;
+    int bits;
+    int opsize;         // 16, 32 or 64
+    int adsize;
+    uint8_t rex;
+    uint8_t rep;        // Last of F2/F3, or 0
+    uint8_t has66;
+    uint8_t mem;        // MEM_* kind of the ModRM memory operand
+    int32_t disp;       // Its displacement, for MEM_ABS and MEM_RIP
+} Decoder;
+
+enum {
+    MEM_NONE,           // No operand at a fixed address
+    MEM_ABS,            // [disp], i.e. "ds:0x..." in objdump
+    MEM_RIP,            // [rip+disp]
+};
+
+#define TRUNCATED (-4)
+
+static int fetch(Decoder *d) {
+    if (d->p >= d->end) {
+        return TRUNCATED;
+    }
+    return *d->p++;
+}
+
+// Consume the SIB byte and displacement that follow modrm
+static int skip_modrm_operand(Decoder *d, uint8_t modrm) {
+    int mod = modrm >> 6;
+    int rm = modrm & 7;
+    size_t disp = 0;
+
+    if (mod == 3) {
+        return 0;
+    }
+    if (d->adsize == 16) {
+        disp = mod == 1 ? 1 : (mod == 2 || (mod == 0 && rm == 6)) ? 2 : 0;
+        if (mod == 0 && rm == 6) {
+            d->mem = MEM_ABS;
+        }
+    } else {
+        if (rm == 4) {
+            int sib = fetch(d);
+            if (sib < 0) {
+                return TRUNCATED;
+            }
+            if (mod == 0 && (sib & 7) == 5) {
+                disp = 4;
+                // No base, and index 100 without REX.X: no index either
+                if (((sib >> 3) & 7) == 4 && !(d->rex & 2)) {
+                    d->mem = MEM_ABS;
+                }
+            }
+        }
+        if (mod == 1) {
+            disp = 1;
+        } else if (mod == 2 || (mod == 0 && rm == 5)) {
+            disp = 4;
+        }
+        if (mod == 0 && rm == 5) {
+            d->mem = d->bits == 64 ? MEM_RIP : MEM_ABS;
+        }
+    }
+    if ((size_t)(d->end - d->p) < disp) {
+        return TRUNCATED;
+    }
+    if (d->mem != MEM_NONE) {
+        d->disp = disp == 2 ? (int32_t)(d->p[0] | d->p[1] << 8)
+                            : (int32_t)((uint32_t)d->p[0] | (uint32_t)d->p[1] << 8 |
+                                        (uint32_t)d->p[2] << 16 | (uint32_t)d->p[3] << 24);
+    }
+    d->p += disp;
+    return 0;
+}
+
+static size_t imm_size(const Decoder *d, int imm) {
+    switch (imm) {
+    case I_B:
+    case I_J8:
+        return 1;
+    case I_W:
+        return 2;
+    case I_Z:
+        return d->opsize == 16 ? 2 : 4;
+    case I_V:
+        return (size_t)d->opsize / 8;
+    case I_JZ:
+        return d->opsize == 16 ? 2 : 4;
+    case I_MOFFS:
+        return (size_t)d->adsize / 8;
+    case I_ENTER:
+        return 3;
+    case I_FAR:
+        return d->opsize == 16 ? 4 : 6;
+    }
+    return 0;
+}
+
+// Read the immediate and, for relative branches, compute the target
+static int read_imm(Decoder *d, int imm, uint64_t addr, X86Insn *insn) {
+    size_t n = imm_size(d, imm);
+    if ((size_t)(d->end - d->p) < n) {
+        return TRUNCATED;
+    }
+    const uint8_t *v = d->p;
+    d->p += n;
+
+    if (imm == I_J8 || imm == I_JZ) {
+        int64_t rel = n == 1 ? (int8_t)v[0]
+                    : n == 2 ? (int16_t)(v[0] | v[1] << 8)
+                    : (int32_t)((uint32_t)v[0] | (uint32_t)v[1] << 8 |
+                                (uint32_t)v[2] << 16 | (uint32_t)v[3] << 24);
+        uint64_t next = addr + (uint64_t)(d->p - d->start);
+        insn->target = next + (uint64_t)rel;
+        if (d->bits == 32) {
+            // A 66 prefix truncates rel16 targets but is ignored on rel8
+            insn->target &= d->opsize == 16 && imm == I_JZ ? 0xFFFFu : 0xFFFFFFFFu;
+        }
+        insn->has_target = 1;
+    }
+    return 0;
+}
+
+// Names that depend on operand size, mode or REX.W rather than opcode
+static int16_t size_variant(const Decoder *d, int16_t mn) {
+    int w = d->rex & 8;
+
+    switch (mn) {
+    case MN_CWDE:
+        return d->opsize == 16 ? MN_CBW : d->opsize == 64 ? MN_CDQE : MN_CWDE;
+    case MN_CDQ:
+        return d->opsize == 16 ? MN_CWD : d->opsize == 64 ? MN_CQO : MN_CDQ;
+    case MN_IRET:
+        return d->opsize == 64 ? MN_IRETQ : d->opsize == 16 ? UNK : MN_IRET;
+    case MN_PUSHA:
+    case MN_POPA:
+    case MN_PUSHF:
+    case MN_POPF:
+        return d->opsize == 16 ? UNK : mn;
+    case MN_JECXZ:
+        return d->adsize == 16 ? MN_JCXZ : d->adsize == 64 ? MN_JRCXZ : MN_JECXZ;
+    case MN_ARPL:
+        return d->bits == 64 ? MN_MOVSXD : MN_ARPL;
+    case MN_SYSRET:
+    case MN_SYSEXIT:
+        return d->bits == 64 ? UNK : mn;     // sysretd/sysretq
+    case MN_RETF:
+        return w ? UNK : mn;                 // retfq
+    case MN_SGDT:
+    case MN_SIDT:
+    case MN_LGDT:
+    case MN_LIDT:
+        return d->bits == 32 ? UNK : mn;     // sgdtw/sgdtd
+    case MN_MOVD:
+        return w ? MN_MOVQ : MN_MOVD;
+    case MN_PEXTRD:
+        return w ? MN_PEXTRQ : MN_PEXTRD;
+    case MN_PINSRD:
+        return w ? MN_PINSRQ : MN_PINSRD;
+    case MN_CMPXCHG8B:
+        return w ? MN_CMPXCHG16B : MN_CMPXCHG8B;
+    case MN_FXSAVE:
+        return w ? MN_FXSAVE64 : mn;
+    case MN_FXRSTOR:
+        return w ? MN_FXRSTOR64 : mn;
+    case MN_XSAVE:
+        return w ? MN_XSAVE64 : mn;
+    case MN_XRSTOR:
+        return w ? MN_XRSTOR64 : mn;
+    case MN_XSAVEOPT:
+        return w ? MN_XSAVEOPT64 : mn;
+    case MN_XSAVEC:
+        return w ? MN_XSAVEC64 : mn;
+    case MN_XSAVES:
+        return w ? MN_XSAVES64 : mn;
+    case MN_XRSTORS:
+        return w ? MN_XRSTORS64 : mn;
+    }
+    return mn;
+}
+
+// 0F 01 with mod == 3 names one instruction per ModRM byte. The bytes
+// objdump knows, one bit per ModRM byte C0-FF, by [64-bit][prefix]:
+static const uint64_t valid_0f01[2][4] = {
+    { 0xFFFFC1FFFFF38F7F, 0x13FF00FFFDF31F3F, 0x17FF05FFFFF30F3F, 0x93FF03FFFFF30F3F },
+    { 0xFFFFC1FFFFF38F7F, 0x13FF00FFFDF3FF3F, 0xF7FFF5FFFFF30F7F, 0xD3FF03FFFFF30F7F },
+};
+
+static int16_t decode_0f01(uint8_t modrm, int pfx, int bits) {
+    if (!(valid_0f01[bits == 64][pfx] >> (modrm - 0xC0) & 1)) {
+        return NA;
+    }
+    switch (modrm) {
+    case 0xC1: return MN_VMCALL;
+    case 0xC2: return MN_VMLAUNCH;
+    case 0xC3: return MN_VMRESUME;
+    case 0xC4: return MN_VMXOFF;
+    case 0xC8: return MN_MONITOR;
+    case 0xC9: return MN_MWAIT;
+    case 0xD0: return MN_XGETBV;
+    case 0xD1: return MN_XSETBV;
+    case 0xD4: return MN_VMFUNC;
+    case 0xD5: return MN_XEND;
+    case 0xD6: return MN_XTEST;
+    case 0xF8: return MN_SWAPGS;
+    case 0xF9: return MN_RDTSCP;
+    }
+    int reg = (modrm >> 3) & 7;
+    if (reg == 4) {
+        return MN_SMSW;
+    }
+    if (reg == 6) {
+        return MN_LMSW;
+    }
+    return UNK;
+}
+
+// The prefix that selects an SSE form: the last of F2/F3, else 66
+static int mandatory_prefix(const Decoder *d) {
+    if (d->rep == 0xF3) {
+        return P_F3;
+    }
+    if (d->rep == 0xF2) {
+        return P_F2;
+    }
+    return d->has66 ? P_66 : P_NONE;
+}
+
+static int16_t group_op(const Decoder *d, const OpInfo *e, uint8_t modrm, uint8_t *imm) {
+    int mod3 = (modrm >> 6) == 3;
+    int reg = (modrm >> 3) & 7;
+    const GroupOp *g = &groups[e->group][mod3][reg];
+    int pfx = mandatory_prefix(d);
+
+    *imm = g->imm != I_NONE ? g->imm : e->imm;
+    switch (e->group) {
+    case G_7:
+        if (!mod3 && reg == 5) {
+            return pfx == P_F3 ? UNK : NA;     // RSTORSSP
+        }
+        return mod3 ? decode_0f01(modrm, pfx, d->bits) : g->mn;
+    case G_9:
+        if (!mod3 && reg == 6) {
+            return pfx == P_66 ? MN_VMCLEAR : pfx == P_F3 ? MN_VMXON : pfx == P_F2 ? NA : MN_VMPTRLD;
+        }
+        if (mod3 && reg >= 6 && pfx == P_F3) {
+            return reg == 7 ? MN_RDPID : d->bits == 64 ? UNK : NA;     // SENDUIPI
+        }
+        if (mod3 && reg >= 6 && pfx == P_F2) {
+            return NA;
+        }
+        break;
+    case G_12:
+    case G_13:
+    case G_14:
+        // PSRLDQ and PSLLDQ exist only with 66
+        if ((reg == 3 || reg == 7) && pfx != P_66) {
+            return NA;
+        }
+        break;
+    case G_15:
+        if (reg < 4) {
+            if (mod3 && pfx == P_F3) {
+                static const int16_t fsgs[4] = { MN_RDFSBASE, MN_RDGSBASE, MN_WRFSBASE, MN_WRGSBASE };
+                return fsgs[reg];
+            }
+            break;
+        }
+        if (mod3 && reg == 7) {
+            return (modrm & 7) == 0 ? MN_SFENCE : NA;    // Any prefix
+        }
+        if (pfx == P_NONE) {
+            return mod3 && reg == 6 && (modrm & 7) != 0 ? NA : g->mn;
+        }
+        // PTWRITE, INCSSP, UMONITOR, CLRSSBSY; TPAUSE; UMWAIT
+        if (pfx == P_F3) {
+            return !mod3 && (reg == 5 || reg == 7) ? NA : UNK;
+        }
+        if (pfx == P_66 && reg >= 6) {
+            return mod3 ? UNK : reg == 6 ? MN_CLWB : MN_CLFLUSHOPT;
+        }
+        return pfx == P_F2 && mod3 && reg == 6 ? UNK : NA;
+    case G_11B:
+    case G_11Z:
+        if (mod3 && reg == 7 && modrm != 0xF8) {
+            return NA;
+        }
+        break;
+    }
+    return g->mn;
+}
+
+// 3DNow! instructions are 0F 0F with the operation in a trailing byte
+static int valid_3dnow(uint8_t suffix) {
+    static const uint8_t ops[] = {
+        0x0C, 0x0D, 0x1C, 0x1D, 0x8A, 0x8E, 0x90, 0x94, 0x96, 0x97, 0x9A, 0x9E,
+        0xA0, 0xA4, 0xA6, 0xA7, 0xAA, 0xAE, 0xB0, 0xB4, 0xB6, 0xB7, 0xBB, 0xBF,
+    };
+    return memchr(ops, suffix, sizeof(ops)) != NULL;
+}
+
+static int16_t decode_x87(uint8_t esc, uint8_t modrm) {
+    int reg = (modrm >> 3) & 7;
+    if ((modrm >> 6) != 3) {
+        return x87_mem[esc][reg];
+    }
+    int16_t mn = x87_reg[esc][reg];
+    return mn == FP_RM ? x87_rm(esc, modrm) : mn;
+}
+
+// objdump's pseudo-op spellings (cmpltps, pclmullqlqdq, ...) are not in
+// mnemonics.def, so those forms count as unknown
+static int16_t pseudo_op(int16_t mn, uint8_t imm) {
+    switch (mn) {
+    case MN_CMPPS: case MN_CMPPD: case MN_CMPSS: case MN_CMPSD:
+        return imm < 8 ? UNK : mn;
+    case MN_VCMPPS: case MN_VCMPPD: case MN_VCMPSS: case MN_VCMPSD:
+        return imm < 32 ? UNK : mn;
+    case MN_PCLMULQDQ: case MN_VPCLMULQDQ:
+        return (imm & 0xEE) == 0 ? UNK : mn;
+    case MN_VPCMPB:
+        return imm == 0 ? MN_VPCMPEQB : imm < 8 && imm != 3 && imm != 7 ? UNK : mn;
+    case MN_VPCMPW:
+        return imm == 0 ? MN_VPCMPEQW : imm < 8 && imm != 3 && imm != 7 ? UNK : mn;
+    case MN_VPCMPD:
+        return imm == 0 ? MN_VPCMPEQD : imm < 8 && imm != 3 && imm != 7 ? UNK : mn;
+    case MN_VPCMPQ:
+        return imm == 0 ? MN_VPCMPEQQ : imm < 8 && imm != 3 && imm != 7 ? UNK : mn;
+    case MN_VPCMPUB: case MN_VPCMPUW: case MN_VPCMPUD: case MN_VPCMPUQ:
+        return imm < 8 && imm != 3 && imm != 7 ? UNK : mn;
+    }
+    return mn;
+}
+
+// VEX (C4/C5) and EVEX (62) instructions, from the byte after the escape.
+// Returns NA for "(bad)", with *opcode_end set to where objdump resumes.
+// Legacy-derived VEX.0F forms objdump rejects as "(bad)": a vvvv
+// register on a two-operand instruction, or VEX.256 on a scalar or
+// 64-bit move
+static int vex_operands_valid(int op, int pp, int vvvv, int l, int mod) {
+    int packed = pp == P_NONE || pp == P_66;
+
+    switch (op) {
+    case 0x10: case 0x11:                       // vmovups/pd; vmovss/sd use vvvv for reg-reg
+        return (!packed && mod == 3) || vvvv == 0;
+    case 0x12: case 0x16:                       // vmovlps/hps loads, vmovsldup/shdup/ddup
+        return packed ? l == 0 : vvvv == 0;
+    case 0x13: case 0x17:                       // vmovlps/hps/lpd/hpd stores
+    case 0x2E: case 0x2F:                       // vucomis*, vcomis*
+    case 0x6E: case 0x7E: case 0xD6:            // vmovd/vmovq
+    case 0xC5:                                  // vpextrw
+        return vvvv == 0 && l == 0;
+    case 0x51: case 0x52: case 0x53:            // vsqrtps/pd, vrsqrtps, vrcpps
+    case 0x5A:                                  // vcvtps2pd, vcvtpd2ps
+        return !packed || vvvv == 0;
+    case 0x28: case 0x29: case 0x2B: case 0x50: case 0x5B:
+    case 0x6F: case 0x70: case 0x7F: case 0xD7: case 0xE6: case 0xE7: case 0xF0:
+        return vvvv == 0;
+    }
+    return 1;
+}
+
+static int16_t decode_vex(Decoder *d, int evex, int c4, const uint8_t **opcode_end) {
+    const uint8_t *escape_end = d->p;
+    int map, pp, w = 0, l = 0, vvvv = 0;
+    int b1 = fetch(d);
+    if (b1 < 0) {
+        return TRUNCATED;
+    }
+    if (evex) {
+        int b2 = fetch(d), b3 = fetch(d);
+        if (b2 < 0 || b3 < 0) {
+            return TRUNCATED;
+        }
+        map = b1 & 7;
+        w = b2 >> 7;
+        pp = b2 & 3;
+        if ((b1 & 0x08) || map == 0 || map == 4 || map == 7) {
+            *opcode_end = escape_end;
+            return NA;
+        }
+        if (!(b2 & 0x04)) {
+            *opcode_end = escape_end + 1;
+            return NA;
+        }
+    } else if (c4) {
+        int b2 = fetch(d);
+        if (b2 < 0) {
+            return TRUNCATED;
+        }
+        map = b1 & 0x1F;
+        w = b2 >> 7;
+        vvvv = (~b2 >> 3) & 15;
+        pp = b2 & 3;
+        l = (b2 >> 2) & 1;
+        if (map < 1 || map > 3) {
+            *opcode_end = escape_end;
+            return NA;
+        }
+    } else {
+        map = 1;
+        vvvv = (~b1 >> 3) & 15;
+        pp = b1 & 3;
+        l = (b1 >> 2) & 1;
+    }
+    if (d->bits == 64) {
+        d->rex = w ? 8 : 0;
+    }
+
+    int op = fetch(d);
+    if (op < 0) {
+        return TRUNCATED;
+    }
+    *opcode_end = d->p;
+
+    // VZEROUPPER/VZEROALL are the only VEX instructions without ModRM
+    if (!evex && map == 1 && op == 0x77) {
+        return pp == P_NONE && vvvv == 0 ? (l ? MN_VZEROALL : MN_VZEROUPPER) : NA;
+    }
+
+    int modrm = fetch(d);
+    if (modrm < 0 || skip_modrm_operand(d, (uint8_t)modrm) < 0) {
+        return TRUNCATED;
+    }
+
+    if (map > 3) {
+        // EVEX maps 5 and 6 (AVX512-FP16): nothing there is in mnemonics.def
+        return NA;
+    }
+
+    const OpInfo *e = map == 1 ? &map_0f[op] : map == 2 ? &map_0f38[op] : &map_0f3a[op];
+    int has_imm = map == 3 || (map == 1 && e->imm == I_B);
+    uint8_t imm = 0;
+    if (has_imm) {
+        int b = fetch(d);
+        if (b < 0) {
+            return TRUNCATED;
+        }
+        imm = (uint8_t)b;
+    }
+
+    int16_t mn = evex ? evex_table[map - 1][pp][op][w] : vex_table[map - 1][pp][op][w];
+    if (mn != NA) {
+        return pseudo_op(mn, imm);
+    }
+
+    // BMI1 group: VEX.0F38 F3 /1 blsr, /2 blsmsk, /3 blsi
+    if (!evex && map == 2 && op == 0xF3 && pp == P_NONE) {
+        static const int16_t bmi[8] = { NA, MN_BLSR, MN_BLSMSK, MN_BLSI, NA, NA, NA, NA };
+        return bmi[(modrm >> 3) & 7];
+    }
+
+    // Otherwise the "V" form of the legacy SSE instruction, if there is one
+    if (!(e->flags & F_OK)) {
+        return NA;
+    }
+    int16_t legacy;
+    if (e->group) {
+        int reg = (modrm >> 3) & 7;
+        if (evex && map == 1 && op == 0x72 && (reg <= 1 || (reg == 4 && w))) {
+            static const int16_t rot[2][2] = { { MN_VPRORD, MN_VPRORQ }, { MN_VPROLD, MN_VPROLQ } };
+            return reg == 4 ? MN_VPSRAQ : rot[reg][w];
+        }
+        if (map == 1 && op == 0xAE) {
+            if (pp != P_NONE || (modrm >> 6) == 3 || (reg != 2 && reg != 3)) {
+                return NA;
+            }
+            return reg == 2 ? MN_VLDMXCSR : MN_VSTMXCSR;
+        }
+        legacy = pp == P_66 ? groups[e->group][(modrm >> 6) == 3][reg].mn : NA;
+    } else if (e->flags & F_SSE) {
+        // An MMX opcode lists the same name under no prefix and 66, and
+        // only its 66 (XMM) form has a VEX encoding
+        legacy = pp == P_NONE && e->mn[P_NONE] == e->mn[P_66] ? NA : e->mn[pp];
+    } else {
+        // MMX-era integer instructions exist in VEX only in their 66 form
+        legacy = pp == P_66 ? e->mn[0] : NA;
+    }
+    if (legacy < 0) {
+        return NA;
+    }
+
+    if (map == 1 && (modrm >> 6) == 3 && pp == P_NONE) {
+        if (legacy == MN_MOVLPS) {
+            legacy = MN_MOVHLPS;
+        } else if (legacy == MN_MOVHPS) {
+            legacy = MN_MOVLHPS;
+        }
+    }
+
+    if (!evex && map == 1 && !vex_operands_valid(op, pp, vvvv, l, modrm >> 6)) {
+        return NA;
+    }
+
+    mn = vex_name[legacy];
+    if (mn == MN_VMOVD && w && d->bits == 64) {
+        mn = MN_VMOVQ;
+    }
+    return mn < 0 ? NA : pseudo_op(mn, imm);
+}
+
+// objdump folds an FWAIT into a following no-wait x87 control
+// instruction and prints the waiting form: 9B DD /6 is "fsave"
+static int16_t waiting_form(int16_t mn) {
+    switch (mn) {
+    case MN_FNCLEX: return MN_FCLEX;
+    case MN_FNINIT: return MN_FINIT;
+    case MN_FNSAVE: return MN_FSAVE;
+    case MN_FNSTCW: return MN_FSTCW;
+    case MN_FNSTENV: return MN_FSTENV;
+    case MN_FNSTSW: return MN_FSTSW;
+    }
+    return NA;
+}
+
+// XOP (8F RXB.mmmmm W.vvvv.L.pp opcode ModRM) has no names in
+// mnemonics.def besides BEXTR, so only the opcode maps are needed to
+// tell objdump's lengths and "(bad)"s apart
+static int16_t decode_xop(Decoder *d, const uint8_t **opcode_end) {
+    static const uint8_t map8[] = {
+        0x85, 0x86, 0x87, 0x8E, 0x8F, 0x95, 0x96, 0x97, 0x9E, 0x9F, 0xA2, 0xA3,
+        0xA6, 0xB6, 0xC0, 0xC1, 0xC2, 0xC3, 0xCC, 0xCD, 0xCE, 0xCF, 0xEC, 0xED,
+        0xEE, 0xEF,
+    };
+    static const uint8_t map9[] = {
+        0x01, 0x02, 0x12, 0x80, 0x81, 0x82, 0x83, 0x90, 0x91, 0x92, 0x93, 0x94,
+        0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0xC1, 0xC2, 0xC3, 0xC6, 0xC7,
+        0xCB, 0xD1, 0xD2, 0xD3, 0xD6, 0xD7, 0xDB, 0xE1, 0xE2, 0xE3,
+    };
+    const uint8_t *escape_end = d->p;
+    int b1 = fetch(d);
+    if (b1 < 0) {
+        return TRUNCATED;
+    }
+    int map = b1 & 0x1F;
+    if (map < 8 || map > 10) {
+        *opcode_end = escape_end;
+        return NA;
+    }
+    int b2 = fetch(d), op = fetch(d);
+    if (b2 < 0 || op < 0) {
+        return TRUNCATED;
+    }
+    *opcode_end = d->p;
+    if (b2 & 3) {
+        return NA;              // XOP has no pp prefixes
+    }
+
+    const uint8_t *ops = map == 8 ? map8 : map9;
+    size_t n = map == 8 ? sizeof(map8) : map == 9 ? sizeof(map9) : 0;
+    int found = map == 10 && (op == 0x10 || op == 0x12);
+    for (size_t i = 0; i < n && !found; i++) {
+        found = ops[i] == op;
+    }
+    if (!found) {
+        return NA;
+    }
+
+    int modrm = fetch(d);
+    if (modrm < 0 || skip_modrm_operand(d, (uint8_t)modrm) < 0) {
+        return TRUNCATED;
+    }
+    size_t imm = map == 8 ? 1 : map == 10 ? 4 : 0;
+    if ((size_t)(d->end - d->p) < imm) {
+        return TRUNCATED;
+    }
+    d->p += imm;
+    return map == 10 && op == 0x10 ? MN_BEXTR : UNK;
+}
+
+// Fill in the length and the address of a fixed memory operand once the
+// whole instruction is decoded: [rip+disp] is relative to its end
+static size_t finish(const Decoder *d, const uint8_t *p, uint64_t addr, X86Insn *insn) {
+    insn->len = (uint8_t)(d->p - p);
+    if (d->mem == MEM_RIP) {
+        insn->mem = addr + insn->len + (uint64_t)(int64_t)d->disp;
+    } else if (d->mem == MEM_ABS) {
+        insn->mem = (uint64_t)(int64_t)d->disp;
+    }
+    if (d->mem != MEM_NONE) {
+        insn->mem &= d->adsize == 64 ? ~(uint64_t)0 : d->adsize == 32 ? 0xFFFFFFFFu : 0xFFFFu;
+        insn->has_mem = 1;
+    }
+    return insn->len;
+}
+
+size_t x86_decode(const uint8_t *p, size_t n, uint64_t addr, int bits, X86Insn *insn) {
+    pthread_once(&tables_once, build_tables);
+
+    Decoder d = {
+        .start = p, .p = p, .end = p + (n < 15 ? n : 15), .bits = bits,
+        .opsize = 32, .adsize = bits,
+    };
+    insn->op = UNK;
+    insn->has_target = 0;
+    insn->target = 0;
+    insn->has_mem = 0;
+    insn->mem = 0;
+
+    size_t waits = 0;
+    while (waits < n && waits < 14 && p[waits] == 0x9B) {
+        waits++;
+    }
+    if (waits > 0 && waits < n && (p[waits] == 0xD9 || p[waits] == 0xDB ||
+                                   p[waits] == 0xDD || p[waits] == 0xDF)) {
+        X86Insn next;
+        x86_decode(p + waits, n - waits, addr + waits, bits, &next);
+        int16_t waited = next.op >= 0 ? waiting_form(next.op) : NA;
+        if (waited != NA && next.len + waits <= 15) {
+            insn->op = waited;
+            insn->len = (uint8_t)(next.len + waits);
+            return insn->len;
+        }
+    }
+
+    int b;
+    for (;;) {
+        b = fetch(&d);
+        if (b < 0) {
+            goto truncated;
+        }
+        if (b == 0x66) {
+            d.has66 = 1;
+        } else if (b == 0x67) {
+            d.adsize = bits == 64 ? 32 : 16;
+        } else if (b == 0xF2 || b == 0xF3) {
+            d.rep = (uint8_t)b;
+        } else if (b == 0xF0 || b == 0x2E || b == 0x36 || b == 0x3E ||
+                   b == 0x26 || b == 0x64 || b == 0x65) {
+            // Lock and segment prefixes
+        } else if (bits == 64 && (b & 0xF0) == 0x40) {
+            // A REX prefix only counts right before the opcode. Followed
+            // by another prefix, objdump prints it (and any prefixes
+            // before it) as an instruction of its own.
+            if (d.p < d.end && (*d.p == 0x66 || *d.p == 0x67 || *d.p == 0xF2 || *d.p == 0xF3 ||
+                                *d.p == 0xF0 || *d.p == 0x2E || *d.p == 0x36 || *d.p == 0x3E ||
+                                *d.p == 0x26 || *d.p == 0x64 || *d.p == 0x65 || *d.p == 0x9B ||
+                                (*d.p & 0xF0) == 0x40)) {
+                insn->op = X86_OP_PREFIX;
+                insn->len = (uint8_t)(d.p - p);
+                return insn->len;
+            }
+            d.rex = (uint8_t)b;
+            continue;
+        } else {
+            break;
+        }
+        d.rex = 0;
+    }
+
+    if (d.rex & 8) {
+        d.opsize = 64;
+    } else if (d.has66) {
+        d.opsize = 16;
+    }
+
+    int16_t mn;
+    const OpInfo *e;
+    const uint8_t *opcode_start = d.p - 1;
+    const uint8_t *opcode_end;
+    uint8_t imm = I_NONE;
+
+    // VEX and EVEX: in 32-bit mode C4, C5 and 62 are LES, LDS and BOUND
+    // unless the next byte would be a register-form ModRM
+    if (b == 0xC4 || b == 0xC5 || b == 0x62) {
+        if (d.p >= d.end) {
+            goto truncated;
+        }
+        if (bits == 64 || (*d.p >> 6) == 3) {
+            mn = decode_vex(&d, b == 0x62, b == 0xC4, &opcode_end);
+            if (mn == TRUNCATED) {
+                goto truncated;
+            }
+            if (mn == NA) {
+                goto bad;
+            }
+            insn->op = mn;
+            return finish(&d, p, addr, insn);
+        }
+    }
+
+    // AMD XOP: 8F is POP only with a zero ModRM reg field
+    if (b == 0x8F && d.p < d.end && (*d.p & 0x38) != 0) {
+        mn = decode_xop(&d, &opcode_end);
+        if (mn == TRUNCATED) {
+            goto truncated;
+        }
+        if (mn == NA) {
+            goto bad;
+        }
+        insn->op = mn;
+        return finish(&d, p, addr, insn);
+    }
+
+    if (b >= 0xD8 && b <= 0xDF) {
+        int modrm = fetch(&d);
+        if (modrm < 0 || skip_modrm_operand(&d, (uint8_t)modrm) < 0) {
+            goto truncated;
+        }
+        mn = decode_x87((uint8_t)(b - 0xD8), (uint8_t)modrm);
+        insn->op = mn < 0 ? UNK : mn;
+        return finish(&d, p, addr, insn);
+    }
+
+    if (b == 0x0F) {
+        b = fetch(&d);
+        if (b < 0) {
+            goto truncated;
+        }
+        if (b == 0x38 || b == 0x3A) {
+            int op = fetch(&d);
+            if (op < 0) {
+                goto truncated;
+            }
+            e = b == 0x38 ? &map_0f38[op] : &map_0f3a[op];
+        } else {
+            e = &map_0f[b];
+        }
+    } else {
+        e = &map_1byte[b];
+    }
+    opcode_end = d.p;
+
+    if (!(e->flags & F_OK) || (bits == 64 && (e->flags & F_INV64))) {
+        goto bad;
+    }
+
+    mn = e->mn[0];
+    imm = e->imm;
+    if (e->flags & F_SSE) {
+        mn = e->mn[mandatory_prefix(&d)];
+        if (mn == NA) {
+            goto bad;
+        }
+    }
+
+    uint8_t modrm = 0;
+    if (e->flags & F_MODRM) {
+        int m = fetch(&d);
+        if (m < 0) {
+            goto truncated;
+        }
+        modrm = (uint8_t)m;
+        if (e->group) {
+            mn = group_op(&d, e, modrm, &imm);
+            if (mn == NA) {
+                goto bad;
+            }
+        }
+
+        int mod3 = (modrm >> 6) == 3;
+        int reg = (modrm >> 3) & 7;
+        // WRSS and the F3 Key Locker forms take memory only; only four
+        // of the F3 0F38 D8 group exist
+        int mem_only = mn == UNK && ((e == &map_0f38[0xF6]) ||
+                                     (e >= &map_0f38[0xDD] && e <= &map_0f38[0xDF]));
+        if (((e->flags & F_MEM) && mod3) || ((e->flags & F_NOMEM) && !mod3) ||
+            ((mn == MN_MOVLPD || mn == MN_MOVHPD || mem_only) && mod3) ||
+            (e == &map_0f38[0xD8] && reg > 3)) {
+            goto bad;
+        }
+        if (((e->flags & F_REGOP) && !mod3) || ((e->flags & F_MEMOP) && mod3) ||
+            ((mn == MN_MOVQ2DQ || mn == MN_MOVDQ2Q) && !mod3) ||
+            ((mn == MN_MOVBE || mn == MN_CMPXCHG8B) && mod3)) {
+            goto bad_operand;
+        }
+        // VIA PadLock: 0F A6 /0-2 and 0F A7 /0-5, register forms only
+        if (mod3 && ((e == &map_0f[0xA6] && reg > 2) || (e == &map_0f[0xA7] && reg > 5))) {
+            goto bad;
+        }
+        if (!(e->flags & F_MODREG) && skip_modrm_operand(&d, modrm) < 0) {
+            goto truncated;
+        }
+    }
+
+    // Opcode-specific names
+    if (e == &map_1byte[0x90]) {
+        mn = (d.rex & 1) ? MN_XCHG : d.rep == 0xF3 ? MN_PAUSE : d.has66 ? MN_XCHG : MN_NOP;
+    } else if (bits == 64 && e >= &map_1byte[0xA0] && e <= &map_1byte[0xA3]) {
+        mn = MN_MOVABS;
+    } else if (e >= &map_1byte[0xB8] && e <= &map_1byte[0xBF] && d.opsize == 64) {
+        mn = MN_MOVABS;
+    } else if (e == &map_0f[0x1E] && d.rep == 0xF3 && (modrm == 0xFA || modrm == 0xFB)) {
+        mn = modrm == 0xFA ? MN_ENDBR64 : MN_ENDBR32;
+    } else if (e == &map_0f[0x1E] && d.rep == 0xF3 && (modrm >> 3) == 0x19) {
+        mn = UNK;       // RDSSPD/RDSSPQ
+    } else if (e == &map_0f[0x1C] && !d.rep && !d.has66 && (modrm >> 6) != 3 &&
+               ((modrm >> 3) & 7) == 0) {
+        mn = UNK;       // CLDEMOTE
+    } else if ((e == &map_0f[0x1A] || e == &map_0f[0x1B]) &&
+               ((modrm >> 6) != 3 || (d.rep ? !(e == &map_0f[0x1B] && d.rep == 0xF3) : d.has66))) {
+        mn = UNK;       // MPX bnd*; only some register forms stay hint NOPs
+    } else if ((e == &map_0f[0x12] || e == &map_0f[0x16]) && (modrm >> 6) == 3 && mn == e->mn[P_NONE]) {
+        mn = e == &map_0f[0x12] ? MN_MOVHLPS : MN_MOVLHPS;
+    } else if (e == &map_0f[0x78] && mn == UNK) {
+        imm = I_W;      // SSE4a EXTRQ/INSERTQ take two imm8
+    }
+    if (((e->flags & F_W16) || ((e->flags & F_W16_64) && bits == 64) || mn == MN_XBEGIN) &&
+        d.opsize == 16) {
+        mn = UNK;
+    }
+
+    if (imm != I_NONE) {
+        const uint8_t *ip = d.p;
+        if (read_imm(&d, imm, addr, insn) < 0) {
+            goto truncated;
+        }
+        if (imm == I_B) {
+            mn = pseudo_op(mn, *ip);
+        }
+        if (e == &map_0f[0x0F] && !valid_3dnow(*ip)) {
+            goto bad_operand;
+        }
+    }
+
+    insn->op = mn < 0 ? UNK : size_variant(&d, mn);
+    return finish(&d, p, addr, insn);
+
+bad:
+    // objdump prints "(bad)" for the prefixes and opcode bytes of an
+    // undefined instruction and resumes decoding at its ModRM byte
+    insn->op = UNK;
+    insn->has_target = 0;
+    insn->len = (uint8_t)(opcode_end - p);
+    return insn->len;
+
+bad_operand:
+    // An operand form the instruction does not have: objdump prints the
+    // name with a "(bad)" operand and resumes after the first opcode byte
+    insn->op = mn < 0 ? UNK : mn;
+    insn->has_target = 0;
+    insn->len = (uint8_t)(opcode_start + 1 - p);
+    return insn->len;
+
+truncated:
+    insn->op = UNK;
+    insn->has_target = 0;
+    insn->len = n > 0 ? 1 : 0;
+    return insn->len;
+}
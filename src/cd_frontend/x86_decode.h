@@ -0,0 +1,30 @@
+#ifndef X86_DECODE_H
+#define X86_DECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// X86Insn.op values besides mnemonics
+#define X86_OP_UNKNOWN  (-1)    // "(bad)", ".byte", or a name outside mnemonics.def
+#define X86_OP_PREFIX   (-2)    // A prefix objdump prints on a line of its own
+
+// One decoded instruction: only what the front-end consumes, i.e. the
+// encoding length, the mnemonic, any direct branch target and the
+// address of a memory operand that does not depend on registers.
+typedef struct {
+    uint8_t len;
+    int16_t op;         // Mnemonic or X86_OP_*
+    uint8_t has_target;
+    uint8_t has_mem;
+    uint64_t target;    // rel8/rel32 destination of a JMP, Jcc, LOOP or CALL
+    uint64_t mem;       // [disp32] or [rip+disp32], e.g. an IAT slot
+} X86Insn;
+
+// Decode the instruction at p[0, n), located at addr, in 32- or 64-bit
+// mode. Mirrors objdump's disassembler so a linear sweep stays in step
+// with `objdump -d`: undefined opcodes decode as "(bad)" of the length
+// objdump consumes, and an instruction cut off by n as a 1-byte ".byte".
+// Always returns insn->len, which is at least 1 when n > 0.
+size_t x86_decode(const uint8_t *p, size_t n, uint64_t addr, int bits, X86Insn *insn);
+
+#endif // X86_DECODE_H